@@ -0,0 +1,58 @@
+#!/bin/sh
+# Benchmark gfa1_parser on synthetic GFA1 files at several scales, reporting the parsing throughput, the peak memory and the time of each phase.
+# Usage: bench.sh [bin directory] [work directory]
+# The scales and the numbers of threads are given by BENCH_SCALES (default "small medium large") and BENCH_THREADS (default "1 4").
+# The generated files are kept in the work directory and reused by later runs.
+
+BINDIR=${1:-bin}
+WORKDIR=${2:-build/bench}
+SCALES=${BENCH_SCALES:-small medium large}
+THREADS=${BENCH_THREADS:-1 4}
+
+generator_options() {
+    case $1 in
+        small) echo "-u 100000 -g 100 -l 10000" ;;
+        medium) echo "-u 1000000 -g 200 -l 50000" ;;
+        large) echo "-u 4000000 -g 400 -l 200000" ;;
+        *) return 1 ;;
+    esac
+}
+
+# Print a summary of a report written with '-r'.
+summarize() {
+    awk -v scale="$1" -v threads="$2" '
+        { gsub(/[",]/, ""); }
+        $1 == "phases:" { in_phases = 1; next; }
+        !in_phases && $1 == "wall_seconds:" { total_seconds = $2; }
+        !in_phases && $1 == "peak_rss_bytes:" { peak_rss = $2; }
+        in_phases && $1 == "name:" { name[++n] = $2; }
+        in_phases && $1 == "wall_seconds:" { wall[n] = $2; }
+        in_phases && $1 == "cpu_seconds:" { cpu[n] = $2; }
+        in_phases && $1 == "lines:" { lines[n] = $2; }
+        in_phases && $1 == "lines_per_second:" { lines_per_second[n] = $2; }
+        in_phases && $1 == "bytes:" { bytes[n] = $2; }
+        in_phases && $1 == "mb_per_second:" { mb_per_second[n] = $2; }
+        END {
+            for (i = 1; i <= n; ++i) if (name[i] == "read_and_parse") parse = i;
+            printf("%-8s %7s %12d %10.1f %12.0f %10.1f %10.1f %12.1f\n", scale, threads, lines[parse], bytes[parse] / 1e6,
+                   lines_per_second[parse], mb_per_second[parse], total_seconds, peak_rss / 1048576);
+            for (i = 1; i <= n; ++i) printf("    %-24s %10.3f s wall %10.3f s cpu\n", name[i], wall[i], cpu[i]);
+        }
+    ' "$3"
+}
+
+mkdir -p "$WORKDIR" || exit 1
+printf "%-8s %7s %12s %10s %12s %10s %10s %12s\n" scale threads lines MB lines/s MB/s total_s peak_RSS_MB
+for scale in $SCALES; do
+    options=$(generator_options "$scale") || { echo "Unknown scale $scale." >&2; exit 1; }
+    input="$WORKDIR/$scale.gfa1"
+    if [ ! -f "$input" ]; then
+        echo "Generating $input." >&2
+        "$BINDIR/gfa1_generator" "$input" $options || exit 1
+    fi
+    for threads in $THREADS; do
+        out="$WORKDIR/${scale}_t$threads"
+        "$BINDIR/gfa1_parser" "$input" "$out" -t "$threads" -r > "$out.log" 2>&1 || { echo "gfa1_parser failed, see $out.log." >&2; exit 1; }
+        summarize "$scale" "$threads" "$out.report.json"
+    done
+done
@@ -0,0 +1,210 @@
+/*
+    Generator of synthetic pangenome GFA1 files in the style of Cuttlefish's output, for benchmarking gfa1_parser.
+
+    A compacted de Bruijn graph is generated first: each unitig is linked to the next one, so that genomes can be long,
+    and to random nearby unitigs at the given link density. Segment and link lines are written interleaved, as Cuttlefish does.
+    Each genome is then a random walk along the links, broken into sequences (contigs) at random or at dead ends,
+    and written as path lines "Reference:<genome>_Sequence:<name>" after all segment and link lines.
+    The output only depends on the options, so the same options always give the same file.
+*/
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "OutputBuffer.hpp"
+
+namespace {
+
+    struct Options {
+        std::string out_filename;
+        uint64_t n_unitigs = 100000;
+        uint64_t n_genomes = 100;
+        uint64_t path_length = 10000;
+        double path_length_spread = 0.1;
+        double n_sequences = 5.0;
+        double link_density = 0.5;
+        uint64_t unitig_length = 100;
+        uint64_t kmer_length = 31;
+        uint64_t seed = 1;
+    };
+
+    // The standard distributions aren't the same across standard libraries, so the generator's own are used.
+    class Random {
+    public:
+        explicit Random(uint64_t seed) : m_rng(seed) { }
+
+        uint64_t uniform(uint64_t n) { return m_rng() % n; }
+        double uniform_real() { return (m_rng() >> 11) / 9007199254740992.0; }
+        bool bernoulli(double p) { return uniform_real() < p; }
+
+    private:
+        std::mt19937_64 m_rng;
+
+    };
+
+    // Oriented unitigs are 2 * id + (orientation == '-').
+    class Graph {
+    public:
+        explicit Graph(uint64_t n_unitigs) : m_neighbors(2 * n_unitigs) { }
+
+        // Add the link and its reverse complement.
+        void add_link(uint64_t from, uint64_t to) {
+            m_neighbors[from].push_back(to);
+            m_neighbors[to ^ 1].push_back(from ^ 1);
+        }
+
+        const std::vector<uint64_t>& neighbors(uint64_t node) const { return m_neighbors[node]; }
+
+    private:
+        std::vector<std::vector<uint64_t>> m_neighbors;
+
+    };
+
+    const uint64_t NEIGHBORHOOD = 1000;
+
+    void print_help() {
+        std::vector<std::string> options{
+            "Usage:", "",
+            "  gfa1_generator [../../output.gfa1] (options)", "",
+            "", "",
+            "Options:", "",
+            "  -u  [ --unitigs ] arg (=100000)", "Number of unitigs.",
+            "  -g  [ --genomes ] arg (=100)", "Number of genome references.",
+            "  -l  [ --path-length ] arg (=10000)", "Mean number of unitigs in the paths of a genome reference.",
+            "  -w  [ --path-length-spread ] arg (=0.1)", "Path lengths are uniform within this fraction of the mean.",
+            "  -c  [ --sequences ] arg (=5)", "Mean number of sequences (path lines) per genome reference.",
+            "  -d  [ --link-density ] arg (=0.5)", "Mean number of links per unitig in addition to the link to the next unitig.",
+            "  -L  [ --unitig-length ] arg (=100)", "Mean unitig length.",
+            "  -k  [ --kmer-length ] arg (=31)", "K-mer length. Links overlap by k - 1.",
+            "  -s  [ --seed ] arg (=1)", "Random seed.",
+            "  -h  [ --help ]", "Print this list.",
+        };
+        for (std::size_t i = 0; i < options.size(); i += 2) std::printf("%-45s %s\n", options[i].data(), options[i + 1].data());
+    }
+
+    bool read_options(int argc, char** argv, Options& options) {
+        if (argc < 2 || argv[1][0] == '-') {
+            print_help();
+            return false;
+        }
+        options.out_filename = argv[1];
+        for (int i = 2; i < argc; ++i) {
+            std::string opt = argv[i];
+            if (opt == "-h" || opt == "--help" || i + 1 == argc) {
+                print_help();
+                return false;
+            }
+            const char* value = argv[++i];
+            if (opt == "-u" || opt == "--unitigs") options.n_unitigs = std::strtoull(value, nullptr, 10);
+            else if (opt == "-g" || opt == "--genomes") options.n_genomes = std::strtoull(value, nullptr, 10);
+            else if (opt == "-l" || opt == "--path-length") options.path_length = std::strtoull(value, nullptr, 10);
+            else if (opt == "-w" || opt == "--path-length-spread") options.path_length_spread = std::strtod(value, nullptr);
+            else if (opt == "-c" || opt == "--sequences") options.n_sequences = std::strtod(value, nullptr);
+            else if (opt == "-d" || opt == "--link-density") options.link_density = std::strtod(value, nullptr);
+            else if (opt == "-L" || opt == "--unitig-length") options.unitig_length = std::strtoull(value, nullptr, 10);
+            else if (opt == "-k" || opt == "--kmer-length") options.kmer_length = std::strtoull(value, nullptr, 10);
+            else if (opt == "-s" || opt == "--seed") options.seed = std::strtoull(value, nullptr, 10);
+            else {
+                std::cerr << "Error: Unknown option " << opt << ".\n";
+                return false;
+            }
+        }
+        bool ok = true;
+        if (options.n_unitigs < 2 || options.n_genomes < 1 || options.path_length < 1) {
+            std::cerr << "Error: At least two unitigs, one genome reference and paths of one unitig are needed.\n";
+            ok = false;
+        }
+        if (options.path_length_spread < 0.0 || options.path_length_spread > 1.0 || options.n_sequences < 1.0 || options.link_density < 0.0) {
+            std::cerr << "Error: Path length spread must be between 0 and 1, sequences at least 1 and link density non-negative.\n";
+            ok = false;
+        }
+        if (options.kmer_length < 2 || options.unitig_length < options.kmer_length) {
+            std::cerr << "Error: K-mer length must be at least 2 and at most the mean unitig length.\n";
+            ok = false;
+        }
+        return ok;
+    }
+
+    uint64_t name(uint64_t node) { return (node >> 1) + 1; }
+    char orientation(uint64_t node) { return node & 1 ? '-' : '+'; }
+
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!read_options(argc, argv, options)) return 1;
+
+    OutputBuffer out;
+    if (!out.open(options.out_filename, true)) {
+        std::cerr << "Error: Can't open " << options.out_filename << ".\n";
+        return 1;
+    }
+    Random random(options.seed);
+    Graph graph(options.n_unitigs);
+    const uint64_t overlap = options.kmer_length - 1;
+    const uint64_t max_extra_length = 2 * (options.unitig_length - options.kmer_length);
+
+    // Segment lines, each followed by the link lines of the unitig. Unitig names are 1, ..., n_unitigs.
+    out << "H\tVN:Z:1.0\n";
+    std::string sequence;
+    for (uint64_t unitig = 0; unitig < options.n_unitigs; ++unitig) {
+        sequence.resize(options.kmer_length + random.uniform(max_extra_length + 1));
+        for (char& c : sequence) c = "ACGT"[random.uniform(4)];
+        out << "S\t" << unitig + 1 << '\t' << sequence << '\n';
+
+        uint64_t n_links = unitig + 1 < options.n_unitigs;
+        double extra_links = options.link_density;
+        for (; extra_links >= 1.0; extra_links -= 1.0) ++n_links;
+        n_links += random.bernoulli(extra_links);
+        for (uint64_t link = 0; link < n_links; ++link) {
+            uint64_t from = 2 * unitig;
+            uint64_t to = 2 * (unitig + 1);
+            if (link > 0 || unitig + 1 == options.n_unitigs) {
+                from += random.uniform(2);
+                uint64_t begin = unitig > NEIGHBORHOOD ? unitig - NEIGHBORHOOD : 0;
+                uint64_t end = std::min(unitig + NEIGHBORHOOD + 1, options.n_unitigs);
+                to = 2 * (begin + random.uniform(end - begin)) + random.uniform(2);
+            }
+            graph.add_link(from, to);
+            out << "L\t" << name(from) << '\t' << orientation(from) << '\t' << name(to) << '\t' << orientation(to) << '\t' << overlap << "M\n";
+        }
+    }
+
+    // Path lines, walking along the links.
+    std::vector<uint64_t> walk;
+    for (uint64_t genome = 0; genome < options.n_genomes; ++genome) {
+        uint64_t spread = options.path_length * options.path_length_spread;
+        uint64_t length = options.path_length - spread + random.uniform(2 * spread + 1);
+        double break_probability = (options.n_sequences - 1.0) / std::max<uint64_t>(length, 1);
+        uint64_t node = 2 * random.uniform(options.n_unitigs) + random.uniform(2);
+        for (uint64_t n_sequences = 0, n_steps = 0; n_steps < length; ++n_sequences) {
+            walk.clear();
+            for (; n_steps < length; ++n_steps) {
+                walk.push_back(node);
+                const auto& neighbors = graph.neighbors(node);
+                bool dead_end = neighbors.empty();
+                node = dead_end ? 2 * random.uniform(options.n_unitigs) + random.uniform(2) : neighbors[random.uniform(neighbors.size())];
+                if (dead_end || random.bernoulli(break_probability)) {
+                    ++n_steps;
+                    break;
+                }
+            }
+            out << "P\tReference:" << genome + 1 << "_Sequence:g" << genome + 1 << "_s" << n_sequences + 1 << '\t';
+            for (std::size_t idx = 0; idx < walk.size(); ++idx) out << (idx ? "," : "") << name(walk[idx]) << orientation(walk[idx]);
+            out << '\t';
+            for (std::size_t idx = 1; idx < walk.size(); ++idx) out << (idx > 1 ? "," : "") << overlap << 'M';
+            if (walk.size() == 1) out << '*';
+            out << '\n';
+        }
+    }
+
+    if (!out.close()) {
+        std::cerr << "Error: Failed to write " << options.out_filename << ".\n";
+        return 1;
+    }
+}
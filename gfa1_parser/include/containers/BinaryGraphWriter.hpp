@@ -0,0 +1,81 @@
+/*
+    Writer for the binary graph format read by unitig_distance, an alternative to the text edges and lengths files.
+
+    Binary graph layout (all integers are 64-bit little-endian words):
+        magic "GFA1BIN\0", version, n_lengths, n_edges, checksum,
+        n_lengths unitig lengths in id order,
+        n_edges edge records of from_id, to_id and overlap << 2 | edge type (FF, FR, RF and RR are 0, 1, 2 and 3).
+    The checksum is a word-wise FNV-1a hash of the words following the header.
+    The lengths come first, so all lengths must be added before any edge.
+*/
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+
+class BinaryGraphWriter {
+public:
+    static constexpr uint64_t VERSION = 1;
+
+    // Starts writing at the current position of the stream.
+    BinaryGraphWriter(std::ostream& os)
+    : m_os(os),
+      m_begin(os.tellp()),
+      m_n_lengths(0),
+      m_n_edges(0),
+      m_checksum(FNV_OFFSET_BASIS)
+    {
+        m_os.write(MAGIC, sizeof(MAGIC));
+        for (int i = 0; i < 4; ++i) write_word(0); // Filled in by finish().
+    }
+
+    void add_length(uint64_t length) {
+        add_word(length);
+        ++m_n_lengths;
+    }
+
+    void add_edge(uint64_t from_id, uint64_t to_id, uint64_t edge_type, uint64_t overlap) {
+        add_word(from_id);
+        add_word(to_id);
+        add_word(overlap << 2 | edge_type);
+        ++m_n_edges;
+    }
+
+    // Fill in the header. The stream is left at the end of the binary graph.
+    bool finish() {
+        auto end = m_os.tellp();
+        m_os.seekp(m_begin + std::streamoff(sizeof(MAGIC)));
+        write_word(VERSION);
+        write_word(m_n_lengths);
+        write_word(m_n_edges);
+        write_word(m_checksum);
+        m_os.seekp(end);
+        return m_os.good();
+    }
+
+private:
+    static constexpr char MAGIC[8] = {'G', 'F', 'A', '1', 'B', 'I', 'N', '\0'};
+    static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+    static constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+    std::ostream& m_os;
+    std::streampos m_begin;
+    uint64_t m_n_lengths;
+    uint64_t m_n_edges;
+    uint64_t m_checksum;
+
+    void add_word(uint64_t word) {
+        m_checksum = (m_checksum ^ word) * FNV_PRIME;
+        write_word(word);
+    }
+
+    void write_word(uint64_t word) {
+        char bytes[8];
+        for (int i = 0; i < 8; ++i) bytes[i] = (word >> (8 * i)) & 0xff;
+        m_os.write(bytes, 8);
+    }
+
+};
+
+constexpr char BinaryGraphWriter::MAGIC[8];
+constexpr uint64_t BinaryGraphWriter::VERSION;
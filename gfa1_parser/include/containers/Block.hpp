@@ -0,0 +1,96 @@
+/*
+    Container for a block of GFA1 lines and the segment, link and path records parsed from them.
+    Names and sequences are referenced, not copied, so they're valid only for the lifetime of the block.
+*/
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "InputBuffer.hpp"
+#include "LineData.hpp"
+#include "StringView.hpp"
+
+struct SegmentRecord {
+    SegmentRecord(const StringView& n, const StringView& seq, uint64_t ln) : name(n), sequence(seq), line_number(ln) { }
+
+    StringView name;
+    StringView sequence;
+    uint64_t line_number;
+};
+
+struct LinkRecord {
+    LinkRecord(const StringView& from_name, char from_o, const StringView& to_name, char to_o, uint64_t ovl, uint64_t ln)
+    : from(from_name), to(to_name), from_orient(from_o), to_orient(to_o), overlap(ovl), line_number(ln) { }
+
+    StringView from;
+    StringView to;
+    char from_orient;
+    char to_orient;
+    uint64_t overlap;
+    uint64_t line_number;
+};
+
+struct PathRecord {
+    PathRecord(std::string&& ref, std::string&& seq, std::string&& names, std::string&& ovls, uint64_t ln)
+    : reference(std::move(ref)), sequence(std::move(seq)), segment_names(std::move(names)), overlaps(std::move(ovls)), line_number(ln) { }
+
+    std::string reference;
+    std::string sequence;
+    std::string segment_names;
+    std::string overlaps;
+    uint64_t line_number;
+};
+
+// Records parsed from a contiguous range of lines in the block, in line order.
+struct BlockRecords {
+    std::vector<SegmentRecord> segments;
+    std::vector<LinkRecord> links;
+    std::vector<PathRecord> paths;
+};
+
+class Block {
+public:
+    Block() : m_n_lines_read(0), m_ends_group(true), m_ok(true) { }
+
+    // Approximate memory a line takes in a block: the input it references, a parsed copy of it in the worst case (path lines),
+    // and its line data and record.
+    static std::size_t line_memory(std::size_t line_size) { return 2 * line_size + sizeof(LineData) + sizeof(LinkRecord); }
+
+    std::vector<LineData>& lines() { return m_lines; }
+    const std::vector<LineData>& lines() const { return m_lines; }
+
+    // Record ranges in line order.
+    std::vector<BlockRecords>& records() { return m_records; }
+
+    // Input buffer chunks that the lines reference.
+    void hold_chunks(std::vector<input_chunk_t>&& chunks) { m_chunks = std::move(chunks); }
+
+    // Position in the input right after the last line of the block.
+    const char* end() const { return m_lines.empty() ? nullptr : m_lines.back().line().end(); }
+
+    // Total number of lines read when this block was finished.
+    std::size_t n_lines_read() const { return m_n_lines_read; }
+    void set_n_lines_read(std::size_t n_lines_read) { m_n_lines_read = n_lines_read; }
+
+    // True if the block is the last of its group of lines. The segment ids are assigned as if all segment lines of a group
+    // came before its link lines, so that they don't depend on how the group is split into blocks.
+    bool ends_group() const { return m_ends_group; }
+    void set_ends_group(bool ends_group) { m_ends_group = ends_group; }
+
+    bool ok() const { return m_ok; }
+    void set_ok(bool ok) { m_ok = ok; }
+
+private:
+    std::vector<LineData> m_lines;
+    std::vector<BlockRecords> m_records;
+    std::vector<input_chunk_t> m_chunks;
+
+    std::size_t m_n_lines_read;
+
+    bool m_ends_group;
+    bool m_ok;
+
+};
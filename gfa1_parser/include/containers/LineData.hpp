@@ -1,30 +1,50 @@
 /*
     Container for data parsed from a GFA1 line.
+    The line is referenced, not copied, so it's only valid as long as the underlying input buffer is.
 */
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <string>
 #include <vector>
 
 #include "gfa1_parser.hpp"
+#include "StringView.hpp"
+
+// Tab-separated fields of a line. Only the first MAX_FIELDS fields are kept, which covers all fields used by the parser.
+class LineFields {
+public:
+    static constexpr std::size_t MAX_FIELDS = 8;
+
+    LineFields(const StringView& line) : m_size(gfa1_parser::get_fields(line, m_fields.data(), MAX_FIELDS)) { }
+
+    std::size_t size() const { return m_size; }
+
+    const StringView& operator[](std::size_t idx) const { return m_fields[idx]; }
+
+    const StringView* begin() const { return m_fields.data(); }
+    const StringView* end() const { return m_fields.data() + m_size; }
+
+private:
+    std::array<StringView, MAX_FIELDS> m_fields;
+    std::size_t m_size;
+
+};
 
 class LineData {
 public:
-    LineData(const std::string& line, uint64_t line_number)
-    : m_fields(gfa1_parser::get_fields(line)),
+    LineData(const StringView& line, uint64_t line_number)
+    : m_line(line),
       m_line_number(line_number)
     { }
 
-    std::vector<std::string>& fields() { return m_fields; }
-    uint64_t line_number() { return m_line_number; }
-
-    std::vector<std::string>::iterator begin() { return m_fields.begin(); }
-    std::vector<std::string>::iterator end() { return m_fields.end(); }
+    const StringView& line() const { return m_line; }
+    LineFields fields() const { return LineFields(m_line); }
+    uint64_t line_number() const { return m_line_number; }
 
 private:
-    std::vector<std::string> m_fields;
+    StringView m_line;
     uint64_t m_line_number;
 
-
 };
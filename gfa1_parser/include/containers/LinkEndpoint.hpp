@@ -1,46 +1,39 @@
 /*
-    Link data type for a link originating from from_id.
+    Link data type for a link originating from from_id, packed into a single 64-bit word:
+    to_id (40 bits) | edge type (2 bits) | overlap class (22 bits).
+    Ordering the words orders the endpoints by to_id, then edge type and then overlap class.
 */
 #pragma once
 
 #include <cstdint>
-#include <string>
-#include <utility>
-
-using edge_type_t = std::pair<char, char>;
 
 class LinkEndpoint {
 public:
-    LinkEndpoint(uint64_t to_id, uint64_t overlap, edge_type_t edge_type)
-    : m_to_id(to_id),
-      m_overlap(overlap),
-      m_edge_type(edge_type)
+    static constexpr uint64_t OVERLAP_CLASS_BITS = 22;
+    static constexpr uint64_t EDGE_TYPE_BITS = 2;
+    static constexpr uint64_t MAX_OVERLAP_CLASSES = 1ULL << OVERLAP_CLASS_BITS;
+
+    LinkEndpoint() : m_data(0) { }
+    LinkEndpoint(uint64_t data) : m_data(data) { }
+    LinkEndpoint(uint64_t to_id, uint64_t edge_type, uint64_t overlap_class)
+    : m_data(to_id << (EDGE_TYPE_BITS + OVERLAP_CLASS_BITS) | edge_type << OVERLAP_CLASS_BITS | overlap_class)
     { }
 
-    const std::string to_string() const { return std::to_string(to_id()) + ' ' + first() + second() + ' ' + std::to_string(overlap()) + 'M'; }
-
-    bool operator==(const LinkEndpoint& other) const {
-        return to_id() == other.to_id() &&
-               edge_type() == other.edge_type() &&
-               overlap() == other.overlap();
-    }
+    // Edge types FF, FR, RF and RR are 0, 1, 2 and 3, respectively.
+    static uint64_t get_edge_type(char from_orient, char to_orient) { return (from_orient == '-') << 1 | (to_orient == '-'); }
 
-    bool operator<(const LinkEndpoint& other) const {
-        return to_id() == other.to_id() ? to_id() < other.to_id() :
-               edge_type() == other.edge_type() ? edge_type() < other.edge_type() :
-               overlap() < other.overlap();
-    }
+    uint64_t data() const { return m_data; }
+    uint64_t to_id() const { return m_data >> (EDGE_TYPE_BITS + OVERLAP_CLASS_BITS); }
+    uint64_t edge_type() const { return m_data >> OVERLAP_CLASS_BITS & ((1ULL << EDGE_TYPE_BITS) - 1); }
+    uint64_t overlap_class() const { return m_data & (MAX_OVERLAP_CLASSES - 1); }
 
-private:
-    uint64_t m_to_id;
-    uint64_t m_overlap;
-    edge_type_t m_edge_type;
+    char first() const { return edge_type() & 2 ? 'R' : 'F'; }
+    char second() const { return edge_type() & 1 ? 'R' : 'F'; }
 
-    uint64_t to_id() const { return m_to_id; }
-    uint64_t overlap() const { return m_overlap; }
-    edge_type_t edge_type() const { return m_edge_type; }
+    bool operator==(const LinkEndpoint& other) const { return m_data == other.m_data; }
+    bool operator<(const LinkEndpoint& other) const { return m_data < other.m_data; }
 
-    char first() const { return m_edge_type.first; }
-    char second() const { return m_edge_type.second; }
+private:
+    uint64_t m_data;
 
 };
@@ -1,74 +1,373 @@
 /*
     Container for GFA1 links.
+    New links are appended to a flat buffer. The buffer is compacted into a CSR layout (ids and offsets of the
+    non-empty rows and packed endpoints), either with a counting sort on from_id when the ids are densely used
+    or with a comparison sort when they're not, so that a single genome's links cost only what they use.
+    Rows are sorted and deduplicated. Compaction happens when the buffer has grown as large as the compacted links
+    and before writing out.
+    With a memory budget, the links are compacted and spilled to a file as a sorted run whenever they exceed it,
+    and the runs are merged with deduplication into a single run before writing out. Once writing or reading back
+    a run fails, spill_failed() is true and the functions that may spill or read the runs return false.
 */
 
 #pragma once
 
 #include <algorithm>
 #include <cstdint>
+#include <cstdio>
 #include <fstream>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "BinaryGraphWriter.hpp"
 #include "LinkEndpoint.hpp"
+#include "OutputBuffer.hpp"
 
 using link_t = LinkEndpoint;
 using links_t = std::vector<LinkEndpoint>;
 
 class Links {
 public:
-    Links() : Links(0) { }
-    Links(std::size_t sz) : m_links(sz), m_n_links(0) { }
+    Links() : m_n_ids(0), m_last_overlap_class(0), m_max_bytes(0), m_n_spilled_links(0), m_n_run_files(0), m_spill_failed(false) { }
 
-    void add_link(uint64_t from_id, uint64_t to_id, char from_orient, char to_orient, uint64_t overlap) {
+    // Spill the links to sorted runs in files filename_prefix.0, filename_prefix.1, ... when they take more than max_bytes of memory.
+    void set_spill(const std::string& filename_prefix, uint64_t max_bytes) {
+        m_spill_prefix = filename_prefix;
+        m_max_bytes = max_bytes;
+    }
+
+    // Returns false if the link has too many distinct overlaps to be stored or if spilling failed.
+    bool add_link(uint64_t from_id, uint64_t to_id, char from_orient, char to_orient, uint64_t overlap) {
         if (from_id > to_id) gfa1_parser::swap(from_id, to_id, from_orient, to_orient);
-        link_t new_link(to_id, overlap, gfa1_parser::get_edge_type(from_orient, to_orient));
-        add_link(from_id, std::move(new_link));
+        uint64_t overlap_class;
+        if (!get_overlap_class(overlap, overlap_class)) return false;
+        return add_link(from_id, link_t(to_id, link_t::get_edge_type(from_orient, to_orient), overlap_class));
     }
 
-    void add_link(uint64_t from_id, link_t&& new_link) {
-        if (from_id >= m_links.size()) resize_to_fit(from_id);
-        if (!contains(from_id, new_link)) {
-            m_links[from_id].push_back(std::move(new_link));
-            ++m_n_links;
+    // Returns false if spilling failed.
+    bool add_link(uint64_t from_id, link_t new_link) {
+        m_n_ids = std::max(m_n_ids, from_id + 1);
+        m_pending.emplace_back(from_id, new_link);
+        if (m_pending.size() >= MIN_COMPACTION_SIZE && m_pending.size() >= m_endpoints.size()) compact_in_memory();
+        if (m_max_bytes > 0 && !m_spill_failed && m_pending.size() % SPILL_CHECK_INTERVAL == 0 && memory_bytes() > m_max_bytes) {
+            compact_in_memory();
+            spill_run();
         }
+        return !m_spill_failed;
     }
 
-    bool contains(uint64_t from_id, const link_t& link) const {
-        const auto& links = m_links[from_id];
-        return std::find(links.begin(), links.end(), link) != links.end();
+    // Sort and deduplicate pending links into the CSR layout, or merge them with the spilled runs into a single run.
+    // Returns false if spilling failed.
+    bool compact() {
+        if (m_spill_failed) return false;
+        compact_in_memory();
+        if (m_runs.empty()) return true;
+        if (!m_endpoints.empty() && !spill_run()) return false;
+        return m_runs.size() == 1 || merge_runs();
     }
 
+    bool spill_failed() const { return m_spill_failed; }
+
     void clear() {
-        gfa1_parser::clear(m_links);
-        m_n_links = 0;
+        for (const auto& run : m_runs) std::remove(run.c_str());
+        gfa1_parser::clear(m_runs);
+        m_n_spilled_links = 0;
+        m_spill_failed = false;
+        gfa1_parser::clear(m_pending);
+        gfa1_parser::clear(m_row_ids);
+        gfa1_parser::clear(m_offsets);
+        gfa1_parser::clear(m_endpoints);
+        gfa1_parser::clear(m_overlaps);
+        gfa1_parser::clear(m_overlap_classes);
+        m_n_ids = 0;
+        m_last_overlap_class = 0;
     }
 
-    uint64_t n_links() const { return m_n_links; }
+    // Exact after compact(), otherwise may count pending and spilled duplicates.
+    uint64_t n_links() const { return m_n_spilled_links + m_endpoints.size() + m_pending.size(); }
 
-    std::size_t capacity() const { return m_links.size(); }
-    void set_capacity(std::size_t capacity) { m_links.resize(capacity); }
+    // Returns false if anything failed to be written or the spilled links couldn't be read back.
+    bool write_out(const std::string& out_filename) {
+        OutputBuffer out;
+        if (!out.open(out_filename)) return false;
+        bool ok = write_out(out);
+        return out.close() && ok;
+    }
 
-    void write_out(const std::string& out_filename) const {
-        std::ofstream ofs(out_filename);
-        for (uint64_t from_id = 0; from_id < m_links.size(); ++from_id) {
-            const auto& links = m_links[from_id];
-            for (const auto& link : links) {
-                ofs << from_id << ' ' << link.to_string() << '\n';
+    // Returns false if the spilled links couldn't be read back.
+    bool write_out(OutputBuffer& out) {
+        return for_each_link([&out](uint64_t from_id, uint64_t to_id, uint64_t edge_type, uint64_t overlap) {
+            out << from_id << ' ' << to_id << ' ' << (edge_type & 2 ? 'R' : 'F') << (edge_type & 1 ? 'R' : 'F') << ' ' << overlap << "M\n";
+        });
+    }
+
+    bool write_out(BinaryGraphWriter& binary_graph) {
+        return for_each_link([&binary_graph](uint64_t from_id, uint64_t to_id, uint64_t edge_type, uint64_t overlap) {
+            binary_graph.add_edge(from_id, to_id, edge_type, overlap);
+        });
+    }
+
+    // Call f(from_id, to_id, edge_type, overlap) for each link in order. Returns false, possibly after calling f for some
+    // of the links, if the links couldn't be spilled or read back.
+    template <typename F>
+    bool for_each_link(F f) {
+        if (!compact()) return false;
+        if (m_runs.empty()) {
+            for_each_compacted_link(f);
+            return true;
+        }
+        RunReader run(m_runs[0]);
+        uint64_t n_links = 0;
+        for ( ; !run.empty(); run.pop(), ++n_links) {
+            f(run.from_id(), run.link().to_id(), run.link().edge_type(), m_overlaps[run.link().overlap_class()]);
+        }
+        if (!run.ok() || n_links != m_n_spilled_links) m_spill_failed = true;
+        return !m_spill_failed;
+    }
+
+    // Same as above for links that are already compacted, e.g. a path's links after Path::compact().
+    template <typename F>
+    void for_each_compacted_link(F f) const {
+        for (uint64_t row = 0; row < m_row_ids.size(); ++row) {
+            for (uint64_t idx = m_offsets[row]; idx < m_offsets[row + 1]; ++idx) {
+                const link_t& link = m_endpoints[idx];
+                f(m_row_ids[row], link.to_id(), link.edge_type(), m_overlaps[link.overlap_class()]);
             }
         }
     }
 
 private:
-    std::vector<links_t> m_links;
+    static constexpr std::size_t MIN_COMPACTION_SIZE = 1024 * 1024;
+    static constexpr std::size_t SPARSE_FACTOR = 8;
+    static constexpr std::size_t SPILL_CHECK_INTERVAL = 64 * 1024;
+    static constexpr std::size_t RUN_WRITE_LINKS = 64 * 1024;
+
+    // Buffered reader of a run file of (from_id, endpoint) word pairs. The run ends early if reading fails.
+    class RunReader {
+    public:
+        RunReader(const std::string& filename) : m_ifs(filename, std::ios::binary), m_pos(0), m_ok(m_ifs.is_open()) { fill(); }
 
-    uint64_t m_n_links;
+        // False if the file couldn't be read or ended in the middle of a pair.
+        bool ok() const { return m_ok; }
+        bool empty() const { return m_pos == m_words.size(); }
+        uint64_t from_id() const { return m_words[m_pos]; }
+        link_t link() const { return link_t(m_words[m_pos + 1]); }
+        void pop() { if ((m_pos += 2) == m_words.size()) fill(); }
 
-    void resize_to_fit(std::size_t sz) {
-        std::size_t new_sz = m_links.size();
-        while (new_sz <= sz) new_sz *= 2;
-        set_capacity(new_sz);
+    private:
+        static constexpr std::size_t BUFFER_WORDS = 1 << 16;
+
+        std::ifstream m_ifs;
+        std::vector<uint64_t> m_words;
+        std::size_t m_pos;
+        bool m_ok;
+
+        void fill() {
+            m_pos = 0;
+            if (!m_ok) {
+                m_words.clear();
+                return;
+            }
+            m_words.resize(BUFFER_WORDS);
+            m_ifs.read(reinterpret_cast<char*>(m_words.data()), BUFFER_WORDS * sizeof(uint64_t));
+            std::size_t n_bytes = m_ifs.gcount();
+            if (m_ifs.bad() || n_bytes % (2 * sizeof(uint64_t)) != 0) m_ok = false;
+            m_words.resize(n_bytes / (2 * sizeof(uint64_t)) * 2);
+        }
+    };
+
+    // Links waiting for compaction.
+    std::vector<std::pair<uint64_t, link_t>> m_pending;
+
+    // Compacted links: the endpoints of from_id m_row_ids[row] are m_endpoints[m_offsets[row]], ..., m_endpoints[m_offsets[row + 1] - 1].
+    std::vector<uint64_t> m_row_ids;
+    std::vector<uint64_t> m_offsets;
+    links_t m_endpoints;
+
+    uint64_t m_n_ids;
+
+    // Distinct overlaps are stored once and referenced by their class.
+    std::vector<uint64_t> m_overlaps;
+    std::unordered_map<uint64_t, uint64_t> m_overlap_classes;
+    uint64_t m_last_overlap_class;
+
+    // Spilled runs, sorted and deduplicated, with the number of links in them.
+    std::string m_spill_prefix;
+    uint64_t m_max_bytes;
+    std::vector<std::string> m_runs;
+    uint64_t m_n_spilled_links;
+    uint64_t m_n_run_files;
+    bool m_spill_failed;
+
+    uint64_t memory_bytes() const {
+        return m_pending.capacity() * sizeof(m_pending[0]) + m_endpoints.capacity() * sizeof(link_t)
+             + (m_row_ids.capacity() + m_offsets.capacity()) * sizeof(uint64_t);
     }
 
-};
+    void compact_in_memory() {
+        if (m_pending.empty()) return;
+        // Counting sort over all ids if they're densely used, comparison sort otherwise (e.g. a single genome's links).
+        // The counting sort needs a word for every id, which may not fit in the memory budget.
+        bool dense = m_endpoints.size() + m_pending.size() >= m_n_ids / SPARSE_FACTOR;
+        if (dense && (m_max_bytes == 0 || (m_n_ids + 1) * sizeof(uint64_t) <= m_max_bytes / 2)) compact_dense();
+        else compact_sparse();
+    }
+
+    std::string next_run_filename() { return m_spill_prefix + '.' + std::to_string(m_n_run_files++); }
 
+    // Write the compacted links to a new run and free their memory. Returns false if writing the run failed.
+    bool spill_run() {
+        m_runs.push_back(next_run_filename());
+        std::ofstream ofs(m_runs.back(), std::ios::binary);
+        std::vector<uint64_t> words;
+        words.reserve(2 * RUN_WRITE_LINKS);
+        for (uint64_t row = 0; ofs && row < m_row_ids.size(); ++row) {
+            for (uint64_t idx = m_offsets[row]; idx < m_offsets[row + 1]; ++idx) {
+                words.push_back(m_row_ids[row]);
+                words.push_back(m_endpoints[idx].data());
+                if (words.size() == 2 * RUN_WRITE_LINKS && !write_words(ofs, words)) break;
+            }
+        }
+        write_words(ofs, words);
+        ofs.close();
+        if (ofs.fail()) m_spill_failed = true;
+        m_n_spilled_links += m_endpoints.size();
+        gfa1_parser::clear(m_row_ids);
+        gfa1_parser::clear(m_offsets);
+        gfa1_parser::clear(m_endpoints);
+        return !m_spill_failed;
+    }
+
+    // k-way merge of the runs into a single run, dropping duplicates. Returns false if reading or writing a run failed.
+    bool merge_runs() {
+        std::vector<std::unique_ptr<RunReader>> runs;
+        for (const auto& run : m_runs) runs.emplace_back(new RunReader(run));
+        using entry_t = std::pair<std::pair<uint64_t, uint64_t>, std::size_t>; // ((from_id, endpoint), run).
+        std::priority_queue<entry_t, std::vector<entry_t>, std::greater<entry_t>> heap;
+        for (std::size_t run = 0; run < runs.size(); ++run) {
+            if (!runs[run]->empty()) heap.emplace(std::make_pair(runs[run]->from_id(), runs[run]->link().data()), run);
+        }
+        std::string merged_filename = next_run_filename();
+        std::ofstream ofs(merged_filename, std::ios::binary);
+        std::vector<uint64_t> words;
+        std::pair<uint64_t, uint64_t> last;
+        uint64_t n_run_links = m_n_spilled_links;
+        uint64_t n_read_links = 0;
+        m_n_spilled_links = 0;
+        while (ofs && !heap.empty()) {
+            entry_t top = heap.top();
+            heap.pop();
+            ++n_read_links;
+            std::size_t run = top.second;
+            runs[run]->pop();
+            if (!runs[run]->empty()) heap.emplace(std::make_pair(runs[run]->from_id(), runs[run]->link().data()), run);
+            if (m_n_spilled_links > 0 && top.first == last) continue;
+            last = top.first;
+            words.push_back(last.first);
+            words.push_back(last.second);
+            ++m_n_spilled_links;
+            if (words.size() == 2 * RUN_WRITE_LINKS) write_words(ofs, words);
+        }
+        write_words(ofs, words);
+        ofs.close();
+        // All links written to the runs must have been read back.
+        for (const auto& run : runs) {
+            if (!run->ok()) m_spill_failed = true;
+        }
+        if (ofs.fail() || n_read_links != n_run_links) m_spill_failed = true;
+        runs.clear();
+        for (const auto& run : m_runs) std::remove(run.c_str());
+        m_runs.assign(1, merged_filename);
+        return !m_spill_failed;
+    }
+
+    // Returns false if writing failed.
+    static bool write_words(std::ofstream& ofs, std::vector<uint64_t>& words) {
+        ofs.write(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(uint64_t));
+        words.clear();
+        return !ofs.fail();
+    }
+
+    void compact_dense() {
+        // Counting sort on from_id: row sizes, exclusive prefix sums, then scatter.
+        std::vector<uint64_t> offsets(m_n_ids + 1);
+        for (uint64_t row = 0; row < m_row_ids.size(); ++row) offsets[m_row_ids[row] + 1] = m_offsets[row + 1] - m_offsets[row];
+        for (const auto& link : m_pending) ++offsets[link.first + 1];
+        for (uint64_t from_id = 0; from_id < m_n_ids; ++from_id) offsets[from_id + 1] += offsets[from_id];
+        links_t endpoints(offsets.back());
+        for (uint64_t row = 0; row < m_row_ids.size(); ++row) {
+            uint64_t& offset = offsets[m_row_ids[row]];
+            offset = std::copy(m_endpoints.begin() + m_offsets[row], m_endpoints.begin() + m_offsets[row + 1], endpoints.begin() + offset) - endpoints.begin();
+        }
+        gfa1_parser::clear(m_endpoints);
+        for (const auto& link : m_pending) endpoints[offsets[link.first]++] = link.second;
+        gfa1_parser::clear(m_pending);
+        // Each offset now points to the end of its row.
+
+        // Sort and deduplicate the rows in place, keeping the non-empty ones.
+        m_row_ids.clear();
+        m_offsets.assign(1, 0);
+        uint64_t n_links = 0;
+        for (uint64_t from_id = 0, row_begin = 0; from_id < m_n_ids; ++from_id) {
+            uint64_t row_end = offsets[from_id];
+            if (row_begin == row_end) continue;
+            std::sort(endpoints.begin() + row_begin, endpoints.begin() + row_end);
+            auto unique_end = std::unique(endpoints.begin() + row_begin, endpoints.begin() + row_end);
+            n_links = std::copy(endpoints.begin() + row_begin, unique_end, endpoints.begin() + n_links) - endpoints.begin();
+            m_row_ids.push_back(from_id);
+            m_offsets.push_back(n_links);
+            row_begin = row_end;
+        }
+        endpoints.resize(n_links);
+        endpoints.shrink_to_fit();
+        m_endpoints.swap(endpoints);
+    }
+
+    void compact_sparse() {
+        for (uint64_t row = 0; row < m_row_ids.size(); ++row) {
+            for (uint64_t idx = m_offsets[row]; idx < m_offsets[row + 1]; ++idx) m_pending.emplace_back(m_row_ids[row], m_endpoints[idx]);
+        }
+        std::sort(m_pending.begin(), m_pending.end(), [](const std::pair<uint64_t, link_t>& a, const std::pair<uint64_t, link_t>& b) {
+            return a.first < b.first || (a.first == b.first && a.second < b.second);
+        });
+        m_pending.erase(std::unique(m_pending.begin(), m_pending.end()), m_pending.end());
 
+        m_row_ids.clear();
+        m_offsets.assign(1, 0);
+        m_endpoints.clear();
+        for (const auto& link : m_pending) {
+            if (m_row_ids.empty() || m_row_ids.back() != link.first) {
+                m_row_ids.push_back(link.first);
+                m_offsets.push_back(m_offsets.back());
+            }
+            m_endpoints.push_back(link.second);
+            ++m_offsets.back();
+        }
+        gfa1_parser::clear(m_pending);
+    }
+
+    bool get_overlap_class(uint64_t overlap, uint64_t& overlap_class) {
+        // Overlaps are usually all the same (k - 1).
+        if (!m_overlaps.empty() && overlap == m_overlaps[m_last_overlap_class]) {
+            overlap_class = m_last_overlap_class;
+            return true;
+        }
+        auto it = m_overlap_classes.find(overlap);
+        if (it != m_overlap_classes.end()) {
+            overlap_class = it->second;
+        } else {
+            if (m_overlaps.size() == link_t::MAX_OVERLAP_CLASSES) return false;
+            overlap_class = m_overlaps.size();
+            m_overlap_classes.emplace(overlap, overlap_class);
+            m_overlaps.push_back(overlap);
+        }
+        m_last_overlap_class = overlap_class;
+        return true;
+    }
+
+};
@@ -0,0 +1,111 @@
+/*
+    Single container file for the edges of the genome references, used instead of one edges file per reference.
+    Each reference's edges are appended as a block with the same contents as its edges file, and write_out()
+    appends an index of the blocks so that they can be read by offset.
+
+    Container file layout (integers are 64-bit little-endian):
+        magic "GFA1SGG\0", n_blocks, index_offset,
+        the blocks back to back,
+        the index at index_offset: n_blocks entries of offset, size, name_length and name_length bytes of name.
+*/
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+class PackedPaths {
+public:
+    PackedPaths() : m_file_size(0) { }
+
+    bool open(const std::string& out_filename) {
+        m_ofs.open(out_filename, std::ios::binary);
+        m_ofs.write(MAGIC, sizeof(MAGIC));
+        m_file_size = sizeof(MAGIC);
+        write_uint64(0); // Number of blocks and index offset, filled in by write_out().
+        write_uint64(0);
+        return m_ofs.good();
+    }
+
+    uint64_t n_blocks() const { return m_names.size(); }
+
+    // Blocks must be added in order.
+    void add_block(const std::string& name, const std::string& block) {
+        m_names.push_back(name);
+        m_offsets.push_back(m_file_size);
+        m_sizes.push_back(block.size());
+        m_ofs.write(block.data(), block.size());
+        m_file_size += block.size();
+    }
+
+    // Copy the blocks of another container, e.g. a previous run's, in order.
+    bool add_blocks(const std::string& filename) {
+        std::ifstream ifs(filename, std::ios::binary);
+        char magic[sizeof(MAGIC)];
+        if (!ifs.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), MAGIC)) return false;
+        uint64_t n_blocks = read_uint64(ifs);
+        uint64_t index_offset = read_uint64(ifs);
+        std::vector<uint64_t> offsets, sizes;
+        std::vector<std::string> names;
+        ifs.seekg(index_offset);
+        for (uint64_t idx = 0; ifs && idx < n_blocks; ++idx) {
+            offsets.push_back(read_uint64(ifs));
+            sizes.push_back(read_uint64(ifs));
+            names.emplace_back(read_uint64(ifs), '\0');
+            ifs.read(&names.back()[0], names.back().size());
+        }
+        std::string block;
+        for (uint64_t idx = 0; ifs && idx < offsets.size(); ++idx) {
+            block.resize(sizes[idx]);
+            ifs.seekg(offsets[idx]);
+            if (ifs.read(&block[0], block.size())) add_block(names[idx], block);
+        }
+        return ifs.good() && offsets.size() == n_blocks;
+    }
+
+    // Write the index and finish the container.
+    bool write_out() {
+        uint64_t index_offset = m_file_size;
+        for (std::size_t idx = 0; idx < m_names.size(); ++idx) {
+            write_uint64(m_offsets[idx]);
+            write_uint64(m_sizes[idx]);
+            write_uint64(m_names[idx].size());
+            m_ofs.write(m_names[idx].data(), m_names[idx].size());
+        }
+        m_ofs.seekp(sizeof(MAGIC));
+        write_uint64(n_blocks());
+        write_uint64(index_offset);
+        m_ofs.close();
+        return !m_ofs.fail();
+    }
+
+private:
+    static constexpr char MAGIC[8] = {'G', 'F', 'A', '1', 'S', 'G', 'G', '\0'};
+
+    std::ofstream m_ofs;
+    uint64_t m_file_size;
+
+    std::vector<std::string> m_names;
+    std::vector<uint64_t> m_offsets;
+    std::vector<uint64_t> m_sizes;
+
+    void write_uint64(uint64_t value) {
+        char bytes[8];
+        for (int i = 0; i < 8; ++i) bytes[i] = (value >> (8 * i)) & 0xff;
+        m_ofs.write(bytes, 8);
+        m_file_size += 8;
+    }
+
+    static uint64_t read_uint64(std::istream& is) {
+        unsigned char bytes[8] = {};
+        is.read(reinterpret_cast<char*>(bytes), 8);
+        uint64_t value = 0;
+        for (int i = 0; i < 8; ++i) value |= (uint64_t) bytes[i] << (8 * i);
+        return value;
+    }
+
+};
+
+constexpr char PackedPaths::MAGIC[8];
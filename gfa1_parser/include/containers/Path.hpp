@@ -1,14 +1,19 @@
 /*
     Path data type.
+    Only the links and segments the path uses are stored, so the cost of a path doesn't depend on the total number of segments.
 */
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include <string>
-#include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "BinaryGraphWriter.hpp"
 #include "LinkEndpoint.hpp"
 #include "Links.hpp"
+#include "OutputBuffer.hpp"
 
 class Path {
 public:
@@ -20,32 +25,53 @@ public:
     const std::string& reference() const { return m_reference; }
     const std::string& sequence() const { return m_sequence; }
 
-    const std::unordered_map<uint64_t, uint64_t>& counts() const { return m_counts; }
+    // Sorted (id, count) pairs of the segments in the path, available after compact().
+    const std::vector<std::pair<uint64_t, uint64_t>>& counts() const { return m_counts; }
 
-    void add_link(uint64_t v, uint64_t w, char v_orient, char w_orient, uint64_t overlap) {
-        m_links.add_link(v, w, v_orient, w_orient, overlap);
+    bool add_link(uint64_t v, uint64_t w, char v_orient, char w_orient, uint64_t overlap) {
+        return m_links.add_link(v, w, v_orient, w_orient, overlap);
     }
 
-    void add_count(uint64_t v) { ++m_counts[v]; }
+    void add_count(uint64_t v) { m_segment_ids.push_back(v); }
 
-    std::size_t capacity() const { return m_links.capacity(); }
-    void set_capacity(std::size_t capacity) { m_links.set_capacity(capacity); }
+    // Sort and deduplicate the links and count the segment occurrences.
+    void compact() {
+        m_links.compact();
+        std::sort(m_segment_ids.begin(), m_segment_ids.end());
+        for (uint64_t v : m_segment_ids) {
+            if (m_counts.empty() || m_counts.back().first != v) m_counts.emplace_back(v, 0);
+            ++m_counts.back().second;
+        }
+        gfa1_parser::clear(m_segment_ids);
+    }
 
-    void write_links(const std::string& out_filename) const {
+    void write_links(const std::string& out_filename) {
         m_links.write_out(out_filename);
     }
 
+    void write_links(OutputBuffer& out) {
+        m_links.write_out(out);
+    }
+
+    void write_links(BinaryGraphWriter& binary_graph) {
+        m_links.write_out(binary_graph);
+    }
+
+    // Call f(from_id, to_id, edge_type, overlap) for each link, available after compact().
+    template <typename F>
+    void for_each_link(F f) const { m_links.for_each_compacted_link(f); }
+
     void write_counts(const std::string& out_filename) const {
-        std::ofstream ofs(out_filename);
-        auto ids = gfa1_parser::map_keys_to_vector(m_counts);
-        for (auto id : ids) {
-            auto count = m_counts.at(id);
-            if (count > 1) ofs << id << ' ' << count << '\n';
+        OutputBuffer out;
+        if (!out.open(out_filename)) return;
+        for (const auto& x : m_counts) {
+            if (x.second > 1) out << x.first << ' ' << x.second << '\n';
         }
     }
 
     void clear() {
         m_links.clear();
+        gfa1_parser::clear(m_segment_ids);
         gfa1_parser::clear(m_counts);
     }
 
@@ -55,6 +81,7 @@ private:
 
     Links m_links;
 
-    std::unordered_map<uint64_t, uint64_t> m_counts; // Stores unitig counts for ids.
+    std::vector<uint64_t> m_segment_ids; // Segment occurrences until compact().
+    std::vector<std::pair<uint64_t, uint64_t>> m_counts; // Stores unitig counts for ids.
 
 };
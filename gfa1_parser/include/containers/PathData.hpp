@@ -1,39 +1,87 @@
 /*
     Container for data parsed from a GFA1 path line.
+    With a memory budget, the path lines kept in memory are appended to a spill file whenever they exceed it.
+    The spilled lines of a path are read back with load() before the path is processed.
 */
 #pragma once
 
 #include <cstdint>
+#include <cstdio>
+#include <fstream>
 #include <string>
 #include <utility>
 #include <vector>
 
 class PathData {
 public:
-    PathData() : m_n_path_lines(0) { }
+    PathData() : m_n_path_lines(0), m_n_bytes(0), m_max_bytes(0), m_spill_size(0) { }
 
-    void add_path_data(uint64_t path_idx, std::string&& segment_names, std::string&& overlaps) {
+    // Spill the path lines to spill_filename when they take more than max_bytes of memory.
+    bool set_spill(const std::string& spill_filename, uint64_t max_bytes) {
+        m_spill_filename = spill_filename;
+        m_max_bytes = max_bytes;
+        m_ofs_spill.open(spill_filename, std::ios::binary);
+        return m_ofs_spill.good();
+    }
+
+    // Returns false if spilling failed.
+    bool add_path_data(uint64_t path_idx, std::string&& segment_names, std::string&& overlaps) {
         if (n_paths() == path_idx) {
             // Make space for new path.
             m_segment_names.emplace_back();
             m_overlaps.emplace_back();
+            m_spilled_offsets.emplace_back();
         }
+        m_n_bytes += line_bytes(segment_names, overlaps);
         m_segment_names[path_idx].push_back(std::move(segment_names));
         m_overlaps[path_idx].push_back(std::move(overlaps));
         ++m_n_path_lines;
+        return m_max_bytes == 0 || m_n_bytes <= m_max_bytes || spill();
     }
 
     uint64_t n_path_lines() const { return m_n_path_lines; }
+    // Lines in memory, all of them after load().
     uint64_t n_path_lines(std::size_t path_idx) const { return m_segment_names[path_idx].size(); }
     uint64_t n_paths() const { return m_segment_names.size(); }
 
     const std::string& segment_names(std::size_t path_idx, std::size_t idx) const { return m_segment_names[path_idx][idx]; }
     const std::string& overlaps(std::size_t path_idx, std::size_t idx) { return m_overlaps[path_idx][idx]; }
 
+    // Read the spilled lines of a path back into memory, in front of the lines in memory. Not thread-safe.
+    bool load(std::size_t path_idx) {
+        auto& offsets = m_spilled_offsets[path_idx];
+        if (offsets.empty()) return true;
+        std::ifstream ifs(m_spill_filename, std::ios::binary);
+        std::vector<std::string> segment_names(offsets.size()), overlaps(offsets.size());
+        for (std::size_t idx = 0; idx < offsets.size(); ++idx) {
+            ifs.seekg(offsets[idx]);
+            uint64_t n_left = m_spill_size - offsets[idx];
+            if (!read_string(ifs, segment_names[idx], n_left) || !read_string(ifs, overlaps[idx], n_left)) return false;
+            m_n_bytes += line_bytes(segment_names[idx], overlaps[idx]);
+        }
+        for (std::size_t idx = 0; idx < m_segment_names[path_idx].size(); ++idx) {
+            segment_names.push_back(std::move(m_segment_names[path_idx][idx]));
+            overlaps.push_back(std::move(m_overlaps[path_idx][idx]));
+        }
+        m_segment_names[path_idx].swap(segment_names);
+        m_overlaps[path_idx].swap(overlaps);
+        gfa1_parser::clear(offsets);
+        return true;
+    }
+
     void clear(std::size_t path_idx) {
+        m_n_path_lines -= n_path_lines(path_idx) + m_spilled_offsets[path_idx].size();
+        for (std::size_t idx = 0; idx < n_path_lines(path_idx); ++idx) m_n_bytes -= line_bytes(m_segment_names[path_idx][idx], m_overlaps[path_idx][idx]);
         gfa1_parser::clear(m_segment_names[path_idx]);
         gfa1_parser::clear(m_overlaps[path_idx]);
-        m_n_path_lines = 0;
+        gfa1_parser::clear(m_spilled_offsets[path_idx]);
+    }
+
+    // Remove the spill file.
+    void remove_spill() {
+        if (m_spill_filename.empty()) return;
+        m_ofs_spill.close();
+        std::remove(m_spill_filename.c_str());
     }
 
 private:
@@ -41,5 +89,49 @@ private:
     std::vector<std::vector<std::string>> m_overlaps;
 
     uint64_t m_n_path_lines;
+    uint64_t m_n_bytes; // Approximate memory of the lines in memory.
+
+    // Spilled lines as length-prefixed segment names and overlaps, with the offsets of each path's lines.
+    std::string m_spill_filename;
+    uint64_t m_max_bytes;
+    std::ofstream m_ofs_spill;
+    uint64_t m_spill_size;
+    std::vector<std::vector<uint64_t>> m_spilled_offsets;
+
+    static uint64_t line_bytes(const std::string& segment_names, const std::string& overlaps) {
+        return 2 * sizeof(std::string) + segment_names.capacity() + overlaps.capacity();
+    }
+
+    // Append the lines in memory to the spill file and free them. Returns false if writing failed.
+    bool spill() {
+        for (std::size_t path_idx = 0; path_idx < n_paths(); ++path_idx) {
+            for (std::size_t idx = 0; idx < n_path_lines(path_idx); ++idx) {
+                m_spilled_offsets[path_idx].push_back(m_spill_size);
+                write_string(m_segment_names[path_idx][idx]);
+                write_string(m_overlaps[path_idx][idx]);
+            }
+            gfa1_parser::clear(m_segment_names[path_idx]);
+            gfa1_parser::clear(m_overlaps[path_idx]);
+        }
+        m_n_bytes = 0;
+        // Flushed here so that the spilled lines can be read back and a failed write is noticed right away.
+        return static_cast<bool>(m_ofs_spill.flush());
+    }
+
+    void write_string(const std::string& str) {
+        uint64_t size = str.size();
+        m_ofs_spill.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        m_ofs_spill.write(str.data(), size);
+        m_spill_size += sizeof(size) + size;
+    }
+
+    // The string and its length must be within the n_left bytes left in the spill file, which are decreased by them.
+    static bool read_string(std::ifstream& ifs, std::string& str, uint64_t& n_left) {
+        uint64_t size = 0;
+        if (n_left < sizeof(size) || !ifs.read(reinterpret_cast<char*>(&size), sizeof(size)) || size > n_left - sizeof(size)) return false;
+        n_left -= sizeof(size) + size;
+        str.resize(size);
+        return static_cast<bool>(ifs.read(&str[0], size));
+    }
 
 };
@@ -1,24 +1,35 @@
 /*
     Container for GFA1 paths.
+    The maximum counts over all paths are reduced with atomics so that paths can be processed in parallel.
 */
 
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "OutputBuffer.hpp"
 #include "Path.hpp"
+#include "StringView.hpp"
 
 class Paths {
 public:
     Paths() : m_n_segments(0) { }
 
     uint64_t n_segments() const { return m_n_segments; }
-    void set_n_segments(uint64_t n_segments) { m_n_segments = n_segments; }
+    // Not thread-safe.
+    void set_n_segments(uint64_t n_segments) {
+        if (n_segments == m_n_segments) return;
+        std::vector<std::atomic<uint64_t>> counts_all(n_segments);
+        for (uint64_t idx = 0; idx < std::min(n_segments, m_n_segments); ++idx) counts_all[idx] = m_counts_all[idx].load();
+        m_counts_all.swap(counts_all);
+        m_n_segments = n_segments;
+    }
 
     Path& path(const std::string& reference) { return (*this)[mapped_idx(reference)]; }
     const Path& path(const std::string& reference) const { return (*this)[mapped_idx(reference)]; }
@@ -34,7 +45,7 @@ public:
         return mapped_idx;
     }
 
-    std::pair<std::string, std::string> parse_cuttlefish_reference_and_sequence(const std::string& pathname) const {
+    static std::pair<std::string, std::string> parse_cuttlefish_reference_and_sequence(const StringView& pathname) {
         static const std::string reference_start_identifier = "Reference:";
         static const std::string sequence_start_identifier = "_Sequence:";
         static const uint64_t reference_skip_ahead = reference_start_identifier.size();
@@ -47,8 +58,8 @@ public:
         uint64_t reference_start = reference_start_idx + reference_skip_ahead;
         uint64_t reference_length = sequence_start_idx - reference_start;
         uint64_t sequence_start = sequence_start_idx + sequence_skip_ahead;
-        std::string reference = pathname.substr(reference_start, reference_length);
-        std::string sequence = pathname.substr(sequence_start);
+        std::string reference = pathname.substr(reference_start, reference_length).to_string();
+        std::string sequence = pathname.substr(sequence_start).to_string();
         return std::make_pair(reference, sequence);
     }
 
@@ -57,42 +68,75 @@ public:
     Path& operator[](std::size_t idx) { return m_paths[idx]; }
     const Path& operator[](std::size_t idx) const { return m_paths[idx]; }
 
-    void add_counts(const std::unordered_map<uint64_t, uint64_t>& counts) {
+    // Thread-safe.
+    void add_counts(const std::vector<std::pair<uint64_t, uint64_t>>& counts) {
         for (const auto& x : counts) {
             uint64_t unitig, unitig_count;
             std::tie(unitig, unitig_count) = x;
-            m_counts_all[unitig] = std::max(m_counts_all[unitig], unitig_count);
+            auto& count_all = m_counts_all[unitig];
+            uint64_t current = count_all.load(std::memory_order_relaxed);
+            while (current < unitig_count && !count_all.compare_exchange_weak(current, unitig_count, std::memory_order_relaxed)) { }
         }
     }
 
-    void write_counts(const std::string& counts_filename) const {
-        std::ofstream ofs(counts_filename);
-        auto counts = gfa1_parser::map_to_vector(m_counts_all, m_n_segments);
+    // Returns the number of lines written.
+    uint64_t write_counts(const std::string& counts_filename) const {
+        OutputBuffer out;
+        if (!out.open(counts_filename)) return 0;
+        uint64_t n_lines = 0;
         for (uint64_t idx = 0; idx < m_n_segments; ++idx) {
-            if (counts[idx] > 1) ofs << idx << ' ' << counts[idx] << '\n';
+            uint64_t count = m_counts_all[idx].load(std::memory_order_relaxed);
+            if (count > 1) {
+                out << idx << ' ' << count << '\n';
+                ++n_lines;
+            }
         }
+        return n_lines;
     }
 
-    void write_to_fasta(std::ofstream& ofs, const Path& path) {
-        ofs << '>' << path.sequence() << '\n';
-        static const uint64_t FASTA_COLS = 60;
-        auto counts = gfa1_parser::map_to_vector(path.counts(), m_n_segments);
-        for (uint64_t idx = 0; idx < m_n_segments; ++idx) {
-            static const std::vector<char> chars{'a', 'c'};
-            ofs << chars[counts[idx] > 0];
-            if ((idx + 1) % FASTA_COLS == 0) ofs << '\n';
+    uint64_t count(uint64_t idx) const { return m_counts_all[idx].load(std::memory_order_relaxed); }
+
+    // The FASTA entry of a path, the sequence being the occurrence pattern of the unitigs.
+    std::string fasta_entry(const Path& path) const {
+        std::string entry;
+        char* row = empty_fasta_entry(path.sequence(), entry);
+        for (const auto& x : path.counts()) {
+            if (x.second > 0) row[x.first + x.first / FASTA_COLS] = 'c';
         }
-        if (m_n_segments % FASTA_COLS != 0) ofs << '\n';
+        return entry;
+    }
+
+    // The FASTA entry of a previous run's path from its occurrence pattern. Unitigs after the end of the pattern are absent.
+    std::string fasta_entry(const std::string& sequence, const std::string& pattern) const {
+        std::string entry;
+        char* row = empty_fasta_entry(sequence, entry);
+        for (uint64_t idx = 0; idx < std::min<uint64_t>(pattern.size(), m_n_segments); ++idx) {
+            if (pattern[idx] == 'c') row[idx + idx / FASTA_COLS] = 'c';
+        }
+        return entry;
     }
 
 private:
+    enum { FASTA_COLS = 60 };
+
     std::vector<Path> m_paths;
     std::unordered_map<std::string, uint64_t> m_path_map;
 
-    std::unordered_map<uint64_t, uint64_t> m_counts_all;
+    std::vector<std::atomic<uint64_t>> m_counts_all;
 
     uint64_t m_n_segments;
 
+    // Make an entry with every unitig absent and return a pointer to its sequence.
+    char* empty_fasta_entry(const std::string& sequence, std::string& entry) const {
+        std::string header = '>' + sequence + '\n';
+        uint64_t n_lines = (m_n_segments + FASTA_COLS - 1) / FASTA_COLS;
+        entry.assign(header.size() + m_n_segments + n_lines, 'a');
+        std::copy(header.begin(), header.end(), entry.begin());
+        char* row = &entry[header.size()];
+        for (uint64_t line = 1; line <= n_lines; ++line) row[std::min<uint64_t>(line * FASTA_COLS, m_n_segments) + line - 1] = '\n';
+        return row;
+    }
+
 };
 
 
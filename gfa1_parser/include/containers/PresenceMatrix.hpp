@@ -0,0 +1,137 @@
+/*
+    Bit-packed presence/absence matrix of the unitigs in the genome references.
+    Rows (one per path, each a bit per segment) are written to a temporary file as the paths are processed.
+    write_out() transposes them chunk by chunk into the column-major matrix file, optionally dropping
+    low-frequency and core unitigs, and writes an index file mapping the kept columns to unitig ids.
+
+    Matrix file layout (integers are 64-bit little-endian):
+        magic "GFA1PAM\0", n_rows, n_columns,
+        n_columns columns of (n_rows + 7) / 8 bytes, bit r (least significant bit first) set if row r contains the unitig.
+*/
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Path.hpp"
+
+class PresenceMatrix {
+public:
+    PresenceMatrix() : m_n_rows(0), m_n_columns(0) { }
+
+    bool open(const std::string& out_filename) {
+        m_tmp_filename = out_filename + ".tmp";
+        m_ofs_rows.open(m_tmp_filename, std::ios::binary);
+        return m_ofs_rows.good();
+    }
+
+    uint64_t n_rows() const { return m_n_rows; }
+
+    // The row of a path. Thread-safe.
+    static std::vector<unsigned char> row(const Path& path, uint64_t n_columns) {
+        std::vector<unsigned char> row((n_columns + 7) / 8);
+        for (const auto& x : path.counts()) row[x.first / 8] |= 1 << (x.first % 8);
+        return row;
+    }
+
+    // The row of a previous run's path from its FASTA occurrence pattern. Unitigs after the end of the pattern are absent.
+    static std::vector<unsigned char> row(const std::string& pattern, uint64_t n_columns) {
+        std::vector<unsigned char> row((n_columns + 7) / 8);
+        for (uint64_t idx = 0; idx < std::min<uint64_t>(pattern.size(), n_columns); ++idx) {
+            if (pattern[idx] == 'c') row[idx / 8] |= 1 << (idx % 8);
+        }
+        return row;
+    }
+
+    // Rows must be added in order and all have the same number of columns.
+    void add_row(const std::vector<unsigned char>& row, uint64_t n_columns) {
+        m_n_columns = n_columns;
+        m_ofs_rows.write(reinterpret_cast<const char*>(row.data()), row.size());
+        ++m_n_rows;
+    }
+
+    /*
+        Write the column-major matrix and its index file. Columns with a minor allele frequency below min_maf are dropped,
+        as are columns present in every row if drop_all_present is set.
+    */
+    bool write_out(const std::string& out_filename, const std::string& index_filename, double min_maf, bool drop_all_present) {
+        m_ofs_rows.close();
+        const uint64_t row_bytes = (m_n_columns + 7) / 8;
+        const uint64_t column_bytes = (m_n_rows + 7) / 8;
+        // Columns per chunk, a multiple of 8 so that chunks start at row byte boundaries.
+        const uint64_t chunk_columns = std::max<uint64_t>(8, CHUNK_BYTES / std::max<uint64_t>(column_bytes, 1) / 8 * 8);
+
+        std::ifstream ifs_rows(m_tmp_filename, std::ios::binary);
+        std::ofstream ofs(out_filename, std::ios::binary);
+        std::ofstream ofs_index(index_filename);
+        ofs.write(MAGIC, sizeof(MAGIC));
+        write_uint64(ofs, m_n_rows);
+        write_uint64(ofs, 0); // Number of kept columns, filled in at the end.
+
+        uint64_t n_kept_columns = 0;
+        std::vector<unsigned char> row_chunk, columns;
+        for (uint64_t column_begin = 0; column_begin < m_n_columns; column_begin += chunk_columns) {
+            uint64_t n_chunk_columns = std::min(chunk_columns, m_n_columns - column_begin);
+            row_chunk.resize((n_chunk_columns + 7) / 8);
+            columns.assign(n_chunk_columns * column_bytes, 0);
+            for (uint64_t row = 0; row < m_n_rows; ++row) {
+                ifs_rows.seekg(row * row_bytes + column_begin / 8);
+                ifs_rows.read(reinterpret_cast<char*>(row_chunk.data()), row_chunk.size());
+                for (uint64_t byte = 0; byte < row_chunk.size(); ++byte) {
+                    for (unsigned bits = row_chunk[byte]; bits; bits &= bits - 1) {
+                        uint64_t column = byte * 8 + count_trailing_zeros(bits);
+                        columns[column * column_bytes + row / 8] |= 1 << (row % 8);
+                    }
+                }
+            }
+            for (uint64_t column = 0; column < n_chunk_columns; ++column) {
+                const unsigned char* bits = columns.data() + column * column_bytes;
+                uint64_t n_present = 0;
+                for (uint64_t byte = 0; byte < column_bytes; ++byte) n_present += popcount(bits[byte]);
+                if (!keep_column(n_present, min_maf, drop_all_present)) continue;
+                ofs.write(reinterpret_cast<const char*>(bits), column_bytes);
+                ofs_index << column_begin + column << '\n';
+                ++n_kept_columns;
+            }
+        }
+        ofs.seekp(sizeof(MAGIC) + sizeof(uint64_t));
+        write_uint64(ofs, n_kept_columns);
+
+        bool ok = ifs_rows && ofs && ofs_index;
+        ifs_rows.close();
+        std::remove(m_tmp_filename.c_str());
+        return ok;
+    }
+
+private:
+    static constexpr char MAGIC[8] = {'G', 'F', 'A', '1', 'P', 'A', 'M', '\0'};
+    static constexpr uint64_t CHUNK_BYTES = 256ULL * 1024 * 1024;
+
+    std::string m_tmp_filename;
+    std::ofstream m_ofs_rows;
+    uint64_t m_n_rows;
+    uint64_t m_n_columns;
+
+    bool keep_column(uint64_t n_present, double min_maf, bool drop_all_present) const {
+        if (drop_all_present && n_present == m_n_rows) return false;
+        if (min_maf <= 0.0) return true;
+        double frequency = (double) n_present / m_n_rows;
+        return std::min(frequency, 1.0 - frequency) >= min_maf;
+    }
+
+    static void write_uint64(std::ofstream& ofs, uint64_t value) {
+        char bytes[8];
+        for (int i = 0; i < 8; ++i) bytes[i] = (value >> (8 * i)) & 0xff;
+        ofs.write(bytes, 8);
+    }
+
+    static int count_trailing_zeros(unsigned bits) { return __builtin_ctz(bits); }
+    static int popcount(unsigned bits) { return __builtin_popcount(bits); }
+
+};
+
+constexpr char PresenceMatrix::MAGIC[8];
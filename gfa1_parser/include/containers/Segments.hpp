@@ -1,62 +1,252 @@
 /*
     Container for (Name, Sequence) pairs given in the GFA1 segment lines.
     The GFA1 Names are mapped to 0, ..., n_segments-1, which will be the new ids for each Sequence.
+    Sequences are written to the unitigs file as they arrive and only their lengths are kept in memory.
+    If they didn't arrive in id order, write_out() reorders the file. Without a unitigs file, only the lengths and hashes of the sequences are kept.
+    Names that are plain decimal integers (as produced by Cuttlefish) are mapped through a directly indexed table.
+    Other names are stored in a contiguous arena and mapped through an open-addressing hash table.
 */
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
+#include "BinaryGraphWriter.hpp"
+#include "OutputBuffer.hpp"
+#include "StringView.hpp"
+
 class Segments {
 public:
-    Segments() = default;
+    static constexpr uint64_t NOT_FOUND = UINT64_MAX;
 
-    std::string& sequence(const std::string& GFA1_NAME) { return (*this)[mapped_idx(GFA1_NAME)]; }
-    const std::string& sequence(const std::string& GFA1_NAME) const { return (*this)[mapped_idx(GFA1_NAME)]; }
+    Segments() : m_n_sequences_in_order(0), m_in_order(true) { }
 
-    uint64_t mapped_idx(const std::string& GFA1_NAME) const {
-        return m_name_map.at(GFA1_NAME);
+    // Open the unitigs file that sequences are written to. Optional.
+    bool open(const std::string& out_filename) {
+        m_out_filename = out_filename;
+        return m_out.open(out_filename);
     }
 
-    bool contains(const std::string& GFA1_NAME) const {
-        return m_name_map.find(GFA1_NAME) != m_name_map.end();
+    // Returns the mapped index of a name or NOT_FOUND.
+    uint64_t find(const StringView& GFA1_NAME) const {
+        uint64_t value;
+        if (parse_integer_name(GFA1_NAME, value)) {
+            if (value < m_integer_map.size() && m_integer_map[value] != NOT_FOUND) return m_integer_map[value];
+            if (m_arena_offsets.size() == 1) return NOT_FOUND; // No names in the arena.
+        }
+        return m_slots.empty() ? NOT_FOUND : m_slots[find_slot(GFA1_NAME, hash(GFA1_NAME))];
     }
 
-    uint64_t map_name(std::string&& GFA1_NAME) {
-        return map_name_and_sequence(std::move(GFA1_NAME), "");
+    bool contains(const StringView& GFA1_NAME) const { return find(GFA1_NAME) != NOT_FOUND; }
+
+    // Returns the mapped index of a name, mapping it first with an empty sequence if necessary.
+    uint64_t map_name(const StringView& GFA1_NAME) {
+        uint64_t value;
+        bool integer_name = parse_integer_name(GFA1_NAME, value);
+        if (integer_name && value < m_integer_map.size() && m_integer_map[value] != NOT_FOUND) return m_integer_map[value];
+        if (!integer_name || m_arena_offsets.size() > 1) {
+            uint64_t mapped_idx = m_slots.empty() ? NOT_FOUND : m_slots[find_slot(GFA1_NAME, hash(GFA1_NAME))];
+            if (mapped_idx != NOT_FOUND) return mapped_idx;
+        }
+        return map_name_and_sequence(GFA1_NAME, StringView());
     }
 
-    uint64_t map_name_and_sequence(std::string&& GFA1_NAME, std::string&& GFA1_SEQUENCE) {
+    // Map a name that has not been mapped before. An empty sequence can be given later with set_sequence().
+    uint64_t map_name_and_sequence(const StringView& GFA1_NAME, const StringView& GFA1_SEQUENCE) {
         uint64_t mapped_idx = size();
-        m_name_map.emplace(std::move(GFA1_NAME), mapped_idx);
-        m_sequences.push_back(std::move(GFA1_SEQUENCE));
+        uint64_t value;
+        if (parse_integer_name(GFA1_NAME, value) && reserve_integer_map(value)) {
+            m_integer_map[value] = mapped_idx;
+            m_names.push_back(value);
+        } else {
+            if (2 * (m_arena_offsets.size() + 1) > m_slots.size()) rehash(m_slots.empty() ? MIN_SLOTS : 2 * m_slots.size());
+            m_slots[find_slot(GFA1_NAME, hash(GFA1_NAME))] = mapped_idx;
+            m_names.push_back(ARENA_NAME | (m_arena_offsets.size() - 1));
+            m_arena.insert(m_arena.end(), GFA1_NAME.begin(), GFA1_NAME.end());
+            m_arena_offsets.push_back(m_arena.size());
+        }
+        m_lengths.push_back(0);
+        m_sequence_offsets.push_back(0);
+        if (!GFA1_SEQUENCE.empty()) set_sequence(mapped_idx, GFA1_SEQUENCE);
         return mapped_idx;
     }
 
-    std::size_t size() const { return m_sequences.size(); }
+    std::size_t size() const { return m_names.size(); }
 
-    std::string& operator[](std::size_t idx) { return m_sequences[idx]; }
-    const std::string& operator[](std::size_t idx) const { return m_sequences[idx]; }
+    bool has_sequence(std::size_t idx) const { return m_lengths[idx] != 0; }
+    uint64_t length(std::size_t idx) const { return m_lengths[idx]; }
+
+    // Write the sequence of a segment that doesn't have one yet.
+    void set_sequence(std::size_t idx, const StringView& GFA1_SEQUENCE) {
+        m_lengths[idx] = GFA1_SEQUENCE.size();
+        if (!m_out.is_open()) {
+            m_sequence_offsets[idx] = hash(GFA1_SEQUENCE);
+            return;
+        }
+        if (idx != m_n_sequences_in_order) m_in_order = false;
+        ++m_n_sequences_in_order;
+        m_out << idx << ' ';
+        m_sequence_offsets[idx] = m_out.position();
+        m_out.write(GFA1_SEQUENCE.data(), GFA1_SEQUENCE.size()).put('\n');
+    }
+
+    // Compare against a sequence that was already written. Only needed for duplicate segment lines, so it's fine to read it back.
+    bool sequence_equals(std::size_t idx, const StringView& GFA1_SEQUENCE) {
+        if (GFA1_SEQUENCE.size() != m_lengths[idx]) return false;
+        if (idx < m_previous_hashes.size()) return hash(GFA1_SEQUENCE) == m_previous_hashes[idx];
+        if (!m_out.is_open()) return hash(GFA1_SEQUENCE) == m_sequence_offsets[idx];
+        m_out.flush();
+        std::string sequence(m_lengths[idx], '\0');
+        std::ifstream ifs(m_out_filename, std::ios::binary);
+        ifs.seekg(m_sequence_offsets[idx]);
+        ifs.read(&sequence[0], sequence.size());
+        return ifs && StringView(sequence) == GFA1_SEQUENCE;
+    }
 
-    void write_out(const std::string& out_filename) const {
-        std::ofstream ofs(out_filename);
+    /*
+        Read the sequences of the names mapped so far from a previous run's unitigs file, which lists them in id order.
+        Their hashes are kept, since the segment lines of a previous run's segments are usually repeated and can't be read back one by one.
+    */
+    bool read_sequences(const std::string& unitigs_filename) {
+        std::ifstream ifs(unitigs_filename);
+        std::string line;
+        std::size_t idx = 0;
+        m_previous_hashes.resize(size());
+        for (; idx < size() && std::getline(ifs, line); ++idx) {
+            StringView fields[2];
+            if (gfa1_parser::get_fields(line, fields, 2, ' ') != 2 || gfa1_parser::to_uint64(fields[0]) != idx || fields[1].empty()) return false;
+            set_sequence(idx, fields[1]);
+            m_previous_hashes[idx] = hash(fields[1]);
+        }
+        return idx == size() && !std::getline(ifs, line);
+    }
+
+    // Finish the unitigs file, reordering it by id if necessary.
+    bool write_out() {
+        if (!m_out.close()) return false;
+        if (m_in_order) return true;
+        std::string tmp_filename = m_out_filename + ".tmp";
+        {
+            std::ifstream ifs(m_out_filename, std::ios::binary);
+            OutputBuffer out;
+            if (!out.open(tmp_filename)) return false;
+            std::string sequence;
+            for (std::size_t idx = 0; idx < size(); ++idx) {
+                sequence.resize(m_lengths[idx]);
+                ifs.seekg(m_sequence_offsets[idx]);
+                ifs.read(&sequence[0], sequence.size());
+                out << idx << ' ' << sequence << '\n';
+            }
+            if (!ifs || !out.close()) return false;
+        }
+        return std::rename(tmp_filename.c_str(), m_out_filename.c_str()) == 0;
+    }
+
+    // Returns false if anything failed to be written.
+    bool write_lengths(const std::string& out_filename) const {
+        OutputBuffer out;
+        if (!out.open(out_filename)) return false;
         for (std::size_t idx = 0; idx < size(); ++idx) {
-            ofs << idx << ' ' << (*this)[idx] << '\n';
+            out << idx << ' ' << m_lengths[idx] << '\n';
         }
+        return out.close();
+    }
+
+    void write_lengths(BinaryGraphWriter& binary_graph) const {
+        for (std::size_t idx = 0; idx < size(); ++idx) binary_graph.add_length(m_lengths[idx]);
     }
 
     // Needed for error-checking.
-    std::string idx_to_gfa1_name(std::size_t idx) {
-        for (const auto& x : m_name_map) if (x.second == idx) return x.first;
-        return "";
+    std::string idx_to_gfa1_name(std::size_t idx) const {
+        if (idx >= m_names.size()) return "";
+        if (m_names[idx] & ARENA_NAME) return arena_name(m_names[idx] & ~ARENA_NAME).to_string();
+        return std::to_string(m_names[idx]);
     }
 
 private:
-    std::vector<std::string> m_sequences;
-    std::unordered_map<std::string, std::size_t> m_name_map;
+    static constexpr uint64_t ARENA_NAME = 1ULL << 63;
+    static constexpr std::size_t MAX_INTEGER_NAME_LENGTH = 18;
+    static constexpr uint64_t MIN_INTEGER_MAP_RANGE = 1ULL << 20;
+    static constexpr std::size_t MIN_SLOTS = 1024;
+
+    std::string m_out_filename;
+    OutputBuffer m_out;
+    std::vector<uint64_t> m_lengths;
+    std::vector<uint64_t> m_sequence_offsets; // Positions of the sequences in the unitigs file, or their hashes without one.
+    uint64_t m_n_sequences_in_order;
+    bool m_in_order;
+    std::vector<uint64_t> m_previous_hashes; // Hashes of the sequences read from a previous run.
+
+    // Reverse index: integer name, or ARENA_NAME | arena index.
+    std::vector<uint64_t> m_names;
+
+    // Integer names.
+    std::vector<uint64_t> m_integer_map;
+
+    // Other names, stored back to back. The i-th name spans [m_arena_offsets[i], m_arena_offsets[i + 1]).
+    std::vector<char> m_arena;
+    std::vector<uint64_t> m_arena_offsets{0};
+    std::vector<uint64_t> m_slots; // Mapped indices of the arena names, NOT_FOUND for empty slots.
+
+    // Integer names without leading zeros, so that e.g. "7" and "007" remain different names.
+    static bool parse_integer_name(const StringView& name, uint64_t& value) {
+        if (name.empty() || name.size() > MAX_INTEGER_NAME_LENGTH || (name[0] == '0' && name.size() > 1)) return false;
+        value = 0;
+        for (char c : name) {
+            if (c < '0' || c > '9') return false;
+            value = value * 10 + (c - '0');
+        }
+        return true;
+    }
+
+    // Grow the integer map to hold value unless this would make the map too sparse. Returns false if the name must go to the arena.
+    bool reserve_integer_map(uint64_t value) {
+        if (value < m_integer_map.size()) return true;
+        if (value >= MIN_INTEGER_MAP_RANGE + 4 * size()) return false;
+        m_integer_map.resize(std::max<uint64_t>(value + 1, 2 * m_integer_map.size()), NOT_FOUND);
+        return true;
+    }
+
+    StringView arena_name(uint64_t arena_idx) const {
+        return StringView(m_arena.data() + m_arena_offsets[arena_idx], m_arena_offsets[arena_idx + 1] - m_arena_offsets[arena_idx]);
+    }
+
+    // FNV-1a.
+    static uint64_t hash(const StringView& name) {
+        uint64_t h = 14695981039346656037ULL;
+        for (char c : name) {
+            h ^= static_cast<unsigned char>(c);
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
+
+    // Returns the slot holding name, or the empty slot where it would be inserted.
+    std::size_t find_slot(const StringView& name, uint64_t h) const {
+        std::size_t mask = m_slots.size() - 1;
+        for (std::size_t slot = h & mask; ; slot = (slot + 1) & mask) {
+            uint64_t mapped_idx = m_slots[slot];
+            if (mapped_idx == NOT_FOUND || arena_name(m_names[mapped_idx] & ~ARENA_NAME) == name) return slot;
+        }
+    }
+
+    void rehash(std::size_t n_slots) {
+        std::vector<uint64_t> slots(n_slots, NOT_FOUND);
+        std::size_t mask = n_slots - 1;
+        for (uint64_t mapped_idx : m_slots) {
+            if (mapped_idx == NOT_FOUND) continue;
+            std::size_t slot = hash(arena_name(m_names[mapped_idx] & ~ARENA_NAME)) & mask;
+            while (slots[slot] != NOT_FOUND) slot = (slot + 1) & mask;
+            slots[slot] = mapped_idx;
+        }
+        m_slots.swap(slots);
+    }
 
 };
 
+constexpr uint64_t Segments::NOT_FOUND;
@@ -0,0 +1,182 @@
+/*
+    Tokenizes and classifies the lines of a block into segment, link and path records using multiple threads.
+    Each thread parses a contiguous range of lines, so the records stay in line order.
+    Besides GFA1 lines, the two files of Cuttlefish's reduced GFA output are supported. The segment file has lines
+    "name<tab>sequence" and the sequence tiling file has lines "path_name<tab>tiling", where the tiling is a space-separated
+    list of oriented segment names such as "12+ 7- 9+". Consecutive segments of a tiling overlap by k - 1, and since the
+    reduced output has no link lines, the links are the ones the tilings use.
+*/
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "gfa1_parser.hpp"
+
+#include "Block.hpp"
+#include "Errors.hpp"
+#include "LineData.hpp"
+#include "Paths.hpp"
+#include "StringView.hpp"
+
+enum class InputFormat { GFA1, CUTTLEFISH_SEGMENTS, CUTTLEFISH_TILINGS };
+
+class BlockParser {
+public:
+    // The tiling overlap (k - 1) is only used for Cuttlefish's sequence tiling files.
+    BlockParser(Errors& errors, std::size_t n_threads, InputFormat format = InputFormat::GFA1, uint64_t tiling_overlap = 0)
+    : m_errors(errors),
+      m_n_threads(std::max<std::size_t>(n_threads, 1)),
+      m_format(format),
+      m_tiling_overlap(tiling_overlap)
+    { }
+
+    bool parse(Block& block) {
+        const auto& lines = block.lines();
+        auto& records = block.records();
+        std::size_t n_threads = std::min(m_n_threads, lines.size() / MIN_LINES_PER_THREAD + 1);
+        records.clear();
+        records.resize(n_threads);
+
+        std::vector<char> ok(n_threads);
+        auto parse_range = [this, &lines, &records, &ok, n_threads](std::size_t thr) {
+            std::size_t begin = lines.size() * thr / n_threads;
+            std::size_t end = lines.size() * (thr + 1) / n_threads;
+            ok[thr] = parse_lines(lines.data() + begin, lines.data() + end, records[thr]);
+        };
+
+        if (n_threads == 1) {
+            parse_range(0);
+        } else {
+            std::vector<std::thread> threads;
+            for (std::size_t thr = 0; thr < n_threads; ++thr) threads.emplace_back(parse_range, thr);
+            for (auto& thr : threads) thr.join();
+        }
+
+        return std::all_of(ok.begin(), ok.end(), [](char thr_ok) { return thr_ok; });
+    }
+
+private:
+    static constexpr std::size_t MIN_LINES_PER_THREAD = 10000;
+
+    Errors& m_errors;
+
+    std::size_t m_n_threads;
+
+    InputFormat m_format;
+    uint64_t m_tiling_overlap;
+
+    bool parse_lines(const LineData* begin, const LineData* end, BlockRecords& records) {
+        for (const LineData* line_data = begin; line_data != end; ++line_data) {
+            bool ok = true;
+            if (m_format == InputFormat::CUTTLEFISH_SEGMENTS) {
+                ok = parse_cuttlefish_segment_line(*line_data, records);
+            } else if (m_format == InputFormat::CUTTLEFISH_TILINGS) {
+                ok = parse_cuttlefish_tiling_line(*line_data, records);
+            } else {
+                switch (line_data->line()[0]) {
+                    case 'S': ok = parse_segment_line(*line_data, records); break;
+                    case 'L': ok = parse_link_line(*line_data, records); break;
+                    case 'P': ok = parse_path_line(*line_data, records); break;
+                    default: break;
+                }
+            }
+            if (!ok) return false;
+        }
+        return true;
+    }
+
+    bool parse_segment_line(const LineData& line_data, BlockRecords& records) {
+        auto fields = line_data.fields();
+        if (fields.size() < 3) {
+            m_errors.report("Segment line has incorrect format.", line_data.line_number());
+            return false;
+        }
+        records.segments.emplace_back(fields[1], fields[2], line_data.line_number());
+        return true;
+    }
+
+    bool parse_link_line(const LineData& line_data, BlockRecords& records) {
+        auto fields = line_data.fields();
+        if (fields.size() < 6) {
+            m_errors.report("Link line has incorrect format.", line_data.line_number());
+            return false;
+        }
+        records.links.emplace_back(fields[1], fields[2][0], fields[3], fields[4][0], gfa1_parser::to_uint64(fields[5]), line_data.line_number());
+        return true;
+    }
+
+    bool parse_path_line(const LineData& line_data, BlockRecords& records) {
+        auto fields = line_data.fields();
+        if (fields.size() < 4) {
+            m_errors.report("Path line has incorrect format.", line_data.line_number());
+            return false;
+        }
+
+        std::string reference, sequence;
+        std::tie(reference, sequence) = Paths::parse_cuttlefish_reference_and_sequence(fields[1]);
+        if (reference.empty() && sequence.empty()) {
+            m_errors.report("Failed to parse path name", line_data.line_number());
+            return false;
+        }
+
+        // The path lines are processed after the whole file has been read, so they must be copied out of the input buffer.
+        records.paths.emplace_back(std::move(reference), std::move(sequence), fields[2].to_string(), fields[3].to_string(), line_data.line_number());
+        return true;
+    }
+
+    bool parse_cuttlefish_segment_line(const LineData& line_data, BlockRecords& records) {
+        auto fields = line_data.fields();
+        if (fields.size() < 2) {
+            m_errors.report("Segment file line has incorrect format.", line_data.line_number());
+            return false;
+        }
+        records.segments.emplace_back(fields[0], fields[1], line_data.line_number());
+        return true;
+    }
+
+    bool parse_cuttlefish_tiling_line(const LineData& line_data, BlockRecords& records) {
+        auto fields = line_data.fields();
+        if (fields.size() < 2) {
+            m_errors.report("Sequence tiling file line has incorrect format.", line_data.line_number());
+            return false;
+        }
+
+        std::string reference, sequence;
+        std::tie(reference, sequence) = Paths::parse_cuttlefish_reference_and_sequence(fields[0]);
+        if (reference.empty() && sequence.empty()) {
+            m_errors.report("Failed to parse path name", line_data.line_number());
+            return false;
+        }
+
+        // Links between consecutive segments, referencing the tiling in the input buffer.
+        const StringView& tiling = fields[1];
+        StringView previous;
+        for (const char* begin = tiling.begin(); begin != tiling.end(); ) {
+            const char* end = static_cast<const char*>(std::memchr(begin, ' ', tiling.end() - begin));
+            if (end == nullptr) end = tiling.end();
+            StringView segment(begin, end);
+            if (segment.size() < 2 || (segment.back() != '+' && segment.back() != '-')) {
+                m_errors.report("Sequence tiling has an invalid oriented segment name", line_data.line_number());
+                return false;
+            }
+            if (!previous.empty()) {
+                records.links.emplace_back(previous.substr(0, previous.size() - 1), previous.back(), segment.substr(0, segment.size() - 1), segment.back(),
+                                           m_tiling_overlap, line_data.line_number());
+            }
+            previous = segment;
+            begin = end == tiling.end() ? end : end + 1;
+        }
+
+        // The overlaps are left empty since they're all the same.
+        records.paths.emplace_back(std::move(reference), std::move(sequence), tiling.to_string(), std::string(), line_data.line_number());
+        return true;
+    }
+
+};
@@ -0,0 +1,119 @@
+/*
+    Pipeline for reading and parsing a GFA1 file, or one of the files of Cuttlefish's reduced GFA output, in blocks.
+    A reader thread splits the input into blocks of lines, a parser thread tokenizes and classifies the lines of each
+    block with multiple worker threads, and the caller consumes the parsed blocks in input order with next_block().
+    The blocks have at most DEFAULT_BLOCK_SIZE lines. With a memory limit, a quarter of it is for the input buffer, which
+    must be constructed with input_memory(), and the rest is shared by the blocks in flight: the ones being read, parsed and
+    consumed and those waiting in the queues. The queues are deeper when the blocks can still be large.
+*/
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <utility>
+
+#include "Block.hpp"
+#include "BlockingQueue.hpp"
+#include "BlockParser.hpp"
+#include "Errors.hpp"
+#include "InputBuffer.hpp"
+#include "LineReader.hpp"
+
+class BlockPipeline {
+public:
+    // Lines per block, unless the memory limit splits the blocks into smaller ones. Segment ids depend only on these groups of lines.
+    static constexpr std::size_t DEFAULT_BLOCK_SIZE = 1000ULL * 1000 * 10;
+
+    // Smallest memory limit that the pipeline keeps to.
+    static constexpr std::size_t MIN_MEMORY = 2ULL * 1024 * 1024;
+
+    // The memory limit is in bytes, 0 for none.
+    BlockPipeline(InputBuffer& input, Errors& errors, std::size_t n_threads, std::size_t max_memory = 0,
+                  InputFormat format = InputFormat::GFA1, uint64_t tiling_overlap = 0)
+    : m_input(input),
+      m_line_reader(errors),
+      m_block_parser(errors, n_threads, format, tiling_overlap),
+      m_read_blocks(queue_depth(max_memory)),
+      m_parsed_blocks(queue_depth(max_memory)),
+      m_max_block_memory(max_block_memory(max_memory))
+    { }
+    BlockPipeline(const BlockPipeline& other) = delete;
+    BlockPipeline& operator=(const BlockPipeline& other) = delete;
+    ~BlockPipeline() { stop(); }
+
+    // Memory limit for the input buffer of a pipeline with the given memory limit.
+    static std::size_t input_memory(std::size_t max_memory) { return max_memory / 4; }
+
+    void start() {
+        m_reader = std::thread(&BlockPipeline::read_blocks, this);
+        m_parser = std::thread(&BlockPipeline::parse_blocks, this);
+    }
+
+    // Get the next parsed block in input order. Returns false when there are no more blocks.
+    bool next_block(Block& block) { return m_parsed_blocks.pop(block); }
+
+    // Stop the pipeline, discarding any blocks that haven't been consumed.
+    void stop() {
+        m_read_blocks.close();
+        m_parsed_blocks.close();
+        if (m_reader.joinable()) m_reader.join();
+        if (m_parser.joinable()) m_parser.join();
+    }
+
+private:
+    static constexpr std::size_t MAX_QUEUE_DEPTH = 4;
+    static constexpr std::size_t MIN_BLOCK_MEMORY = 256ULL * 1024;
+    static constexpr std::size_t LARGE_BLOCK_MEMORY = 64ULL * 1024 * 1024;
+
+    InputBuffer& m_input;
+    LineReader m_line_reader;
+    BlockParser m_block_parser;
+
+    BlockingQueue<Block> m_read_blocks;
+    BlockingQueue<Block> m_parsed_blocks;
+
+    std::size_t m_max_block_memory;
+
+    std::thread m_reader;
+    std::thread m_parser;
+
+    // The blocks being read, parsed and consumed and those in the two queues.
+    static std::size_t n_blocks_in_flight(std::size_t queue_depth) { return 3 + 2 * queue_depth; }
+
+    // As deep queues as fit with blocks of at least LARGE_BLOCK_MEMORY, but at least 1.
+    static std::size_t queue_depth(std::size_t max_memory) {
+        std::size_t depth = 1;
+        std::size_t blocks_memory = max_memory - input_memory(max_memory);
+        while (depth < MAX_QUEUE_DEPTH && blocks_memory / n_blocks_in_flight(depth + 1) >= LARGE_BLOCK_MEMORY) ++depth;
+        return depth;
+    }
+
+    static std::size_t max_block_memory(std::size_t max_memory) {
+        if (max_memory == 0) return std::numeric_limits<std::size_t>::max();
+        std::size_t block_memory = (max_memory - input_memory(max_memory)) / n_blocks_in_flight(queue_depth(max_memory));
+        return block_memory > MIN_BLOCK_MEMORY ? block_memory : MIN_BLOCK_MEMORY;
+    }
+
+    void read_blocks() {
+        for (std::size_t idx = 0; !m_input.eof(); ) {
+            Block block;
+            std::size_t group_end = idx - idx % DEFAULT_BLOCK_SIZE + DEFAULT_BLOCK_SIZE;
+            bool ok = m_line_reader.read_next_block(m_input, block, idx, group_end, m_max_block_memory);
+            block.set_ok(ok);
+            if (!m_read_blocks.push(std::move(block)) || !ok) break;
+        }
+        m_read_blocks.close();
+    }
+
+    void parse_blocks() {
+        Block block;
+        while (m_read_blocks.pop(block)) {
+            if (block.ok()) block.set_ok(m_block_parser.parse(block));
+            bool ok = block.ok();
+            if (!m_parsed_blocks.push(std::move(block)) || !ok) break;
+        }
+        m_parsed_blocks.close();
+    }
+
+};
@@ -0,0 +1,55 @@
+/*
+    Bounded queue for passing work between the threads of the block pipeline.
+*/
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+template <typename T>
+class BlockingQueue {
+public:
+    BlockingQueue(std::size_t capacity) : m_capacity(capacity), m_closed(false) { }
+
+    // Blocks while the queue is full. Returns false if the queue has been closed.
+    bool push(T&& item) {
+        std::unique_lock<std::mutex> lock(m_mtx);
+        m_not_full.wait(lock, [this] { return m_closed || m_queue.size() < m_capacity; });
+        if (m_closed) return false;
+        m_queue.push_back(std::move(item));
+        m_not_empty.notify_one();
+        return true;
+    }
+
+    // Blocks while the queue is empty. Returns false if the queue has been closed and drained.
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(m_mtx);
+        m_not_empty.wait(lock, [this] { return m_closed || !m_queue.empty(); });
+        if (m_queue.empty()) return false;
+        item = std::move(m_queue.front());
+        m_queue.pop_front();
+        m_not_full.notify_one();
+        return true;
+    }
+
+    // No more items can be pushed, remaining items can still be popped.
+    void close() {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        m_closed = true;
+        m_not_full.notify_all();
+        m_not_empty.notify_all();
+    }
+
+private:
+    std::deque<T> m_queue;
+    std::size_t m_capacity;
+    bool m_closed;
+
+    std::mutex m_mtx;
+    std::condition_variable m_not_full;
+    std::condition_variable m_not_empty;
+
+};
@@ -0,0 +1,242 @@
+/*
+    Class for accessing the lines of a GFA1 file without copying them.
+    Uncompressed regular files are memory-mapped. Other inputs (gzip/bgzip-compressed files, pipes, FIFOs and stdin as "-")
+    are decompressed and read in large chunks by a separate thread. The chunks holding the lines returned by next_line()
+    are handed out with take_chunks() and stay alive for as long as someone holds on to them.
+    With a memory limit, the chunks in the queue and the memory-mapped pages not yet released stay within about that much.
+*/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <zlib.h>
+
+#include "BlockingQueue.hpp"
+#include "StringView.hpp"
+
+using input_chunk_t = std::shared_ptr<std::vector<char>>;
+
+class InputBuffer {
+public:
+    InputBuffer(std::size_t max_memory = 0)
+    : m_gz_file(nullptr),
+      m_chunks(CHUNK_QUEUE_CAPACITY),
+      m_chunk_size(chunk_size(max_memory)),
+      m_mapped(nullptr),
+      m_mapped_size(0),
+      m_release_threshold(max_memory > 0 ? max_memory : RELEASE_THRESHOLD),
+      m_begin(nullptr),
+      m_end(nullptr),
+      m_released(nullptr),
+      m_eof(false),
+      m_error(false)
+    { }
+    InputBuffer(const InputBuffer& other) = delete;
+    InputBuffer& operator=(const InputBuffer& other) = delete;
+    ~InputBuffer() { close(); }
+
+    // Open a file, or stdin if filename is "-". Can only be called once.
+    bool open(const std::string& filename) {
+        #ifndef WIN32
+        if (filename != "-" && open_mapped(filename)) return true;
+        #endif
+        m_gz_file = filename == "-" ? gzdopen(fileno(stdin), "rb") : gzopen(filename.c_str(), "rb");
+        if (m_gz_file == nullptr) return false;
+        gzbuffer(m_gz_file, GZ_BUFFER_SIZE);
+        m_reader = std::thread(&InputBuffer::read_chunks, this);
+        return true;
+    }
+
+    bool memory_mapped() const { return m_mapped != nullptr; }
+
+    // True when all lines have been consumed.
+    bool eof() const { return m_begin == m_end && m_eof; }
+
+    bool error() const { return m_error; }
+
+    // Get the next line without its line break. Returns false at the end of input or on a read error.
+    bool next_line(StringView& line) {
+        while (m_begin == m_end) {
+            if (m_eof || !next_chunk()) return false;
+        }
+        const char* line_end = static_cast<const char*>(std::memchr(m_begin, '\n', m_end - m_begin));
+        if (line_end == nullptr) {
+            // Last line has no line break.
+            line = StringView(m_begin, m_end);
+            m_begin = m_end;
+        } else {
+            line = StringView(m_begin, line_end);
+            m_begin = line_end + 1;
+        }
+        return true;
+    }
+
+    // Get the chunks referenced by lines returned since the last call. Lines stay valid while the chunks are held.
+    std::vector<input_chunk_t> take_chunks() {
+        std::vector<input_chunk_t> chunks;
+        chunks.swap(m_referenced_chunks);
+        if (m_chunk) m_referenced_chunks.push_back(m_chunk);
+        return chunks;
+    }
+
+    // Signal that the memory-mapped input before position is no longer referenced. May be called from another thread than next_line().
+    void release(const char* position) {
+        #ifndef WIN32
+        if (!memory_mapped() || position == nullptr) return;
+        static const std::size_t page_size = sysconf(_SC_PAGESIZE);
+        std::size_t n_consumed = position - m_released;
+        std::size_t n_release = n_consumed - n_consumed % page_size;
+        if (n_release == 0 || n_release < m_release_threshold) return;
+        // Let the kernel drop pages that have already been processed to keep the resident set small.
+        madvise(const_cast<char*>(m_released), n_release, MADV_DONTNEED);
+        m_released += n_release;
+        #endif
+    }
+
+    void close() {
+        m_chunks.close();
+        if (m_reader.joinable()) m_reader.join();
+        if (m_gz_file != nullptr) gzclose(m_gz_file);
+        #ifndef WIN32
+        if (m_mapped != nullptr) munmap(m_mapped, m_mapped_size);
+        #endif
+        m_gz_file = nullptr;
+        m_mapped = nullptr;
+        m_mapped_size = 0;
+        m_begin = m_end = m_released = nullptr;
+        m_eof = true;
+        m_chunk.reset();
+        std::vector<input_chunk_t>().swap(m_referenced_chunks);
+    }
+
+private:
+    static constexpr std::size_t CHUNK_SIZE = 64ULL * 1024 * 1024;
+    static constexpr std::size_t MIN_CHUNK_SIZE = 64ULL * 1024;
+    static constexpr std::size_t CHUNK_QUEUE_CAPACITY = 4;
+    static constexpr unsigned GZ_BUFFER_SIZE = 1024 * 1024;
+    static constexpr std::size_t RELEASE_THRESHOLD = 256ULL * 1024 * 1024;
+
+    // Streaming mode.
+    gzFile m_gz_file;
+    std::thread m_reader;
+    BlockingQueue<input_chunk_t> m_chunks; // Chunks read by the reader thread, each ending at a line break except the last one.
+    input_chunk_t m_chunk;
+    std::vector<input_chunk_t> m_referenced_chunks; // Chunks referenced since the last call to take_chunks().
+    std::size_t m_chunk_size;
+
+    // Memory-mapped mode.
+    void* m_mapped;
+    std::size_t m_mapped_size;
+    std::size_t m_release_threshold;
+
+    const char* m_begin;
+    const char* m_end;
+    const char* m_released;
+
+    bool m_eof;
+    std::atomic<bool> m_error;
+
+    static std::size_t chunk_size(std::size_t max_memory) {
+        if (max_memory == 0) return CHUNK_SIZE;
+        // The chunks in the queue, the current one and the one being read.
+        std::size_t size = max_memory / (CHUNK_QUEUE_CAPACITY + 2);
+        return size > MIN_CHUNK_SIZE ? size : MIN_CHUNK_SIZE;
+    }
+
+    bool next_chunk() {
+        input_chunk_t chunk;
+        if (!m_chunks.pop(chunk)) {
+            m_eof = true;
+            return false;
+        }
+        m_chunk = chunk;
+        m_referenced_chunks.push_back(chunk);
+        m_begin = m_chunk->data();
+        m_end = m_begin + m_chunk->size();
+        return true;
+    }
+
+    // Reader thread: decompress the input into chunks of complete lines, carrying over the partial line at the end of each chunk.
+    void read_chunks() {
+        std::vector<char> carry;
+        bool eof = false;
+        while (!eof) {
+            std::size_t chunk_size = m_chunk_size;
+            while (chunk_size < 2 * carry.size()) chunk_size *= 2; // Very long line.
+            input_chunk_t chunk = std::make_shared<std::vector<char>>(chunk_size);
+            std::copy(carry.begin(), carry.end(), chunk->begin());
+
+            std::size_t sz = carry.size();
+            while (sz < chunk->size()) {
+                unsigned n_request = std::min<std::size_t>(chunk->size() - sz, 1U << 30);
+                int n_read = gzread(m_gz_file, chunk->data() + sz, n_request);
+                if (n_read <= 0) {
+                    int errnum = Z_OK;
+                    gzerror(m_gz_file, &errnum);
+                    if (n_read < 0 || errnum != Z_OK) m_error = true; // Read error or truncated input.
+                    eof = true;
+                    break;
+                }
+                sz += n_read;
+            }
+
+            // Cut the chunk after its last line break.
+            std::size_t chunk_end = sz;
+            if (!eof) {
+                while (chunk_end > 0 && (*chunk)[chunk_end - 1] != '\n') --chunk_end;
+            }
+            carry.assign(chunk->begin() + chunk_end, chunk->begin() + sz);
+            if (chunk_end == 0) continue; // No complete lines yet.
+            chunk->resize(chunk_end);
+            if (!m_chunks.push(std::move(chunk))) break;
+        }
+        m_chunks.close();
+    }
+
+    #ifndef WIN32
+    bool open_mapped(const std::string& filename) {
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0) {
+            ::close(fd);
+            return false;
+        }
+        void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // The mapping stays valid after closing the file descriptor.
+        if (mapped == MAP_FAILED) return false;
+        const unsigned char* magic = static_cast<const unsigned char*>(mapped);
+        if (info.st_size >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+            // Compressed file, must be streamed.
+            munmap(mapped, info.st_size);
+            return false;
+        }
+        madvise(mapped, info.st_size, MADV_SEQUENTIAL);
+        m_mapped = mapped;
+        m_mapped_size = info.st_size;
+        m_begin = m_released = static_cast<const char*>(mapped);
+        m_end = m_begin + m_mapped_size;
+        m_eof = true;
+        return true;
+    }
+    #endif
+
+};
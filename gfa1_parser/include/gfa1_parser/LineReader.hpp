@@ -3,56 +3,48 @@
 */
 #pragma once
 
-#include <fstream>
 #include <string>
-#include <thread>
 #include <utility>
 #include <vector>
 
+#include "Block.hpp"
 #include "Errors.hpp"
+#include "InputBuffer.hpp"
 #include "LineData.hpp"
-
-using line_data_container_t = std::vector<LineData>;
+#include "StringView.hpp"
 
 class LineReader {
 public:
     LineReader(Errors& errors) : m_errors(errors) { }
 
-    line_data_container_t& segment_line_data() { return m_segment_line_data; }
-    line_data_container_t& link_line_data() { return m_link_line_data; }
-    line_data_container_t& path_line_data() { return m_path_line_data; }
-
-    void clear() {
-        // Use std::vector::clear here as the memory will soon be reused.
-        m_segment_line_data.clear();
-        m_link_line_data.clear();
-        m_path_line_data.clear();
-    }
-
-    bool read_next_block(std::ifstream& ifs, std::size_t& idx, std::size_t block_end) {
-        for (std::string line; idx != block_end && std::getline(ifs, line); ++idx) {
+    // Read lines until line group_end or until the block takes about max_block_memory bytes, but at least one line.
+    // The block takes ownership of the input buffer chunks that its lines reference.
+    bool read_next_block(InputBuffer& input, Block& block, std::size_t& idx, std::size_t group_end, std::size_t max_block_memory) {
+        auto& lines = block.lines();
+        StringView line;
+        bool ok = true;
+        std::size_t block_memory = 0;
+        for ( ; idx != group_end && block_memory < max_block_memory && input.next_line(line); ++idx) {
             uint64_t line_number = idx + 1;
             if (line.size() == 0) {
                 m_errors.report("Empty line", line_number);
-                return false;
-            }
-            char record_type = line[0];
-            switch (record_type) {
-                case 'S': m_segment_line_data.emplace_back(line, line_number); break;
-                case 'L': m_link_line_data.emplace_back(line, line_number); break;
-                case 'P': m_path_line_data.emplace_back(line, line_number); break;
-                default: break;
+                ok = false;
+                break;
             }
+            lines.emplace_back(line, line_number);
+            block_memory += Block::line_memory(line.size());
+        }
+        if (ok && input.error()) {
+            m_errors.report("Failed to read input", idx + 1);
+            ok = false;
         }
-        return true;
+        block.hold_chunks(input.take_chunks());
+        block.set_n_lines_read(idx);
+        block.set_ends_group(idx == group_end || input.eof());
+        return ok;
     }
 
 private:
-    line_data_container_t m_segment_line_data;
-    line_data_container_t m_link_line_data;
-    line_data_container_t m_path_line_data;
-
     Errors& m_errors;
 
 };
-
@@ -0,0 +1,35 @@
+/*
+    Memory budget for parsing a GFA1 file, given e.g. as 64G: half of it for the links, a quarter for the path lines and
+    a quarter for reading and parsing blocks, see BlockPipeline. Past their shares, the links and the path lines are spilled
+    to disk.
+*/
+#pragma once
+
+#include <cctype>
+#include <cstdint>
+#include <string>
+
+class MemoryBudget {
+public:
+    // Smallest budget, whose share for reading and parsing blocks is the least the block pipeline can keep to.
+    static constexpr uint64_t MIN_MEMORY = 8ULL * 1024 * 1024;
+
+    static constexpr uint64_t links_memory(uint64_t max_memory) { return max_memory / 2; }
+    static constexpr uint64_t path_lines_memory(uint64_t max_memory) { return max_memory / 4; }
+    static constexpr uint64_t pipeline_memory(uint64_t max_memory) { return max_memory / 4; }
+
+    // Parse a size such as 512M or 64G, with suffixes K, M, G and T for powers of 1024.
+    static bool parse(const std::string& str, uint64_t& size) {
+        std::size_t pos = 0;
+        size = 0;
+        for (; pos < str.size() && str[pos] >= '0' && str[pos] <= '9'; ++pos) size = size * 10 + (str[pos] - '0');
+        if (pos == 0 || size == 0 || pos + 1 < str.size()) return false;
+        if (pos == str.size()) return true;
+        const std::string suffixes = "KMGT";
+        std::size_t exponent = suffixes.find(std::toupper(str[pos]));
+        if (exponent == std::string::npos) return false;
+        size <<= 10 * (exponent + 1);
+        return true;
+    }
+
+};
@@ -0,0 +1,276 @@
+/*
+    Formatting of integers and doubles into character buffers without going through streams or printf.
+    Doubles are written with digits that read back to the same value, found with Grisu2 and the shortest possible
+    in all but rare cases, in the notation %g would choose for them, e.g. 0.25, 3, 1e-05 and 1.7976931348623157e+308.
+    Integer-valued doubles below 2^53 are written as integers directly.
+    Each function writes at most MAX_LENGTH characters and returns a pointer past the last one.
+*/
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+class NumberFormat {
+public:
+    enum { MAX_LENGTH = 32 };
+
+    static char* format_uint(uint64_t value, char* out) {
+        static const char DIGIT_PAIRS[] =
+            "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+            "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+        char* end = out + n_digits(value);
+        char* pos = end;
+        while (value >= 100) {
+            const char* pair = DIGIT_PAIRS + 2 * (value % 100);
+            value /= 100;
+            *--pos = pair[1];
+            *--pos = pair[0];
+        }
+        if (value >= 10) {
+            *--pos = DIGIT_PAIRS[2 * value + 1];
+            *--pos = DIGIT_PAIRS[2 * value];
+        } else {
+            *--pos = '0' + value;
+        }
+        return end;
+    }
+
+    static char* format_int(int64_t value, char* out) {
+        if (value >= 0) return format_uint(value, out);
+        *out++ = '-';
+        return format_uint(-(uint64_t) value, out);
+    }
+
+    static char* format_double(double value, char* out) {
+        if (std::signbit(value)) {
+            *out++ = '-';
+            value = -value;
+        }
+        if (std::isnan(value)) return copy("nan", out);
+        if (std::isinf(value)) return copy("inf", out);
+        if (value < 9007199254740992.0 && value == (double) (uint64_t) value) return format_uint((uint64_t) value, out);
+
+        char digits[18];
+        int n_digits = 0, decimal_exponent = 0;
+        grisu2(value, digits, n_digits, decimal_exponent);
+
+        // The value is 0.d_1...d_n * 10^point, use fixed notation if %g would.
+        int point = n_digits + decimal_exponent;
+        if (point > -4 && point <= 17) {
+            if (point <= 0) {
+                out = copy("0.", out);
+                std::memset(out, '0', -point);
+                out += -point;
+                std::memcpy(out, digits, n_digits);
+                return out + n_digits;
+            }
+            if (point >= n_digits) {
+                std::memcpy(out, digits, n_digits);
+                std::memset(out + n_digits, '0', point - n_digits);
+                return out + point;
+            }
+            std::memcpy(out, digits, point);
+            out[point] = '.';
+            std::memcpy(out + point + 1, digits + point, n_digits - point);
+            return out + n_digits + 1;
+        }
+
+        *out++ = digits[0];
+        if (n_digits > 1) {
+            *out++ = '.';
+            std::memcpy(out, digits + 1, n_digits - 1);
+            out += n_digits - 1;
+        }
+        int exponent = point - 1;
+        *out++ = 'e';
+        *out++ = exponent < 0 ? '-' : '+';
+        if (exponent < 0) exponent = -exponent;
+        if (exponent < 10) *out++ = '0';
+        return format_uint(exponent, out);
+    }
+
+private:
+    // Floating-point number f * 2^e with a 64-bit significand.
+    struct DiyFp {
+        uint64_t f;
+        int e;
+        DiyFp(uint64_t f_, int e_) : f(f_), e(e_) { }
+    };
+
+    // Normalized 10^k as f * 2^e.
+    struct CachedPower {
+        uint64_t f;
+        int e;
+        int k;
+    };
+
+    static int n_digits(uint64_t value) {
+        int n = 1;
+        for (;;) {
+            if (value < 10) return n;
+            if (value < 100) return n + 1;
+            if (value < 1000) return n + 2;
+            if (value < 10000) return n + 3;
+            value /= 10000;
+            n += 4;
+        }
+    }
+
+    static char* copy(const char* str, char* out) {
+        while (*str) *out++ = *str++;
+        return out;
+    }
+
+    // Upper 64 bits of the 128-bit product, rounded.
+    static DiyFp multiply(const DiyFp& x, const DiyFp& y) {
+        uint64_t x_lo = x.f & 0xffffffffULL, x_hi = x.f >> 32;
+        uint64_t y_lo = y.f & 0xffffffffULL, y_hi = y.f >> 32;
+        uint64_t p0 = x_lo * y_lo, p1 = x_lo * y_hi, p2 = x_hi * y_lo, p3 = x_hi * y_hi;
+        uint64_t mid = (p0 >> 32) + (p1 & 0xffffffffULL) + (p2 & 0xffffffffULL) + (1ULL << 31);
+        return DiyFp(p3 + (p1 >> 32) + (p2 >> 32) + (mid >> 32), x.e + y.e + 64);
+    }
+
+    static DiyFp normalize(DiyFp x) {
+        while ((x.f >> 63) == 0) {
+            x.f <<= 1;
+            --x.e;
+        }
+        return x;
+    }
+
+    // Cached powers 10^-300, 10^-292, ..., 10^324.
+    static const CachedPower& cached_power(int idx) {
+        static const CachedPower CACHED_POWERS[] = {
+            { 0xAB70FE17C79AC6CAULL, -1060, -300 }, { 0xFF77B1FCBEBCDC4FULL, -1034, -292 },
+            { 0xBE5691EF416BD60CULL, -1007, -284 }, { 0x8DD01FAD907FFC3CULL, -980, -276 },
+            { 0xD3515C2831559A83ULL, -954, -268 }, { 0x9D71AC8FADA6C9B5ULL, -927, -260 },
+            { 0xEA9C227723EE8BCBULL, -901, -252 }, { 0xAECC49914078536DULL, -874, -244 },
+            { 0x823C12795DB6CE57ULL, -847, -236 }, { 0xC21094364DFB5637ULL, -821, -228 },
+            { 0x9096EA6F3848984FULL, -794, -220 }, { 0xD77485CB25823AC7ULL, -768, -212 },
+            { 0xA086CFCD97BF97F4ULL, -741, -204 }, { 0xEF340A98172AACE5ULL, -715, -196 },
+            { 0xB23867FB2A35B28EULL, -688, -188 }, { 0x84C8D4DFD2C63F3BULL, -661, -180 },
+            { 0xC5DD44271AD3CDBAULL, -635, -172 }, { 0x936B9FCEBB25C996ULL, -608, -164 },
+            { 0xDBAC6C247D62A584ULL, -582, -156 }, { 0xA3AB66580D5FDAF6ULL, -555, -148 },
+            { 0xF3E2F893DEC3F126ULL, -529, -140 }, { 0xB5B5ADA8AAFF80B8ULL, -502, -132 },
+            { 0x87625F056C7C4A8BULL, -475, -124 }, { 0xC9BCFF6034C13053ULL, -449, -116 },
+            { 0x964E858C91BA2655ULL, -422, -108 }, { 0xDFF9772470297EBDULL, -396, -100 },
+            { 0xA6DFBD9FB8E5B88FULL, -369, -92 }, { 0xF8A95FCF88747D94ULL, -343, -84 },
+            { 0xB94470938FA89BCFULL, -316, -76 }, { 0x8A08F0F8BF0F156BULL, -289, -68 },
+            { 0xCDB02555653131B6ULL, -263, -60 }, { 0x993FE2C6D07B7FACULL, -236, -52 },
+            { 0xE45C10C42A2B3B06ULL, -210, -44 }, { 0xAA242499697392D3ULL, -183, -36 },
+            { 0xFD87B5F28300CA0EULL, -157, -28 }, { 0xBCE5086492111AEBULL, -130, -20 },
+            { 0x8CBCCC096F5088CCULL, -103, -12 }, { 0xD1B71758E219652CULL, -77, -4 },
+            { 0x9C40000000000000ULL, -50, 4 }, { 0xE8D4A51000000000ULL, -24, 12 },
+            { 0xAD78EBC5AC620000ULL, 3, 20 }, { 0x813F3978F8940984ULL, 30, 28 },
+            { 0xC097CE7BC90715B3ULL, 56, 36 }, { 0x8F7E32CE7BEA5C70ULL, 83, 44 },
+            { 0xD5D238A4ABE98068ULL, 109, 52 }, { 0x9F4F2726179A2245ULL, 136, 60 },
+            { 0xED63A231D4C4FB27ULL, 162, 68 }, { 0xB0DE65388CC8ADA8ULL, 189, 76 },
+            { 0x83C7088E1AAB65DBULL, 216, 84 }, { 0xC45D1DF942711D9AULL, 242, 92 },
+            { 0x924D692CA61BE758ULL, 269, 100 }, { 0xDA01EE641A708DEAULL, 295, 108 },
+            { 0xA26DA3999AEF774AULL, 322, 116 }, { 0xF209787BB47D6B85ULL, 348, 124 },
+            { 0xB454E4A179DD1877ULL, 375, 132 }, { 0x865B86925B9BC5C2ULL, 402, 140 },
+            { 0xC83553C5C8965D3DULL, 428, 148 }, { 0x952AB45CFA97A0B3ULL, 455, 156 },
+            { 0xDE469FBD99A05FE3ULL, 481, 164 }, { 0xA59BC234DB398C25ULL, 508, 172 },
+            { 0xF6C69A72A3989F5CULL, 534, 180 }, { 0xB7DCBF5354E9BECEULL, 561, 188 },
+            { 0x88FCF317F22241E2ULL, 588, 196 }, { 0xCC20CE9BD35C78A5ULL, 614, 204 },
+            { 0x98165AF37B2153DFULL, 641, 212 }, { 0xE2A0B5DC971F303AULL, 667, 220 },
+            { 0xA8D9D1535CE3B396ULL, 694, 228 }, { 0xFB9B7CD9A4A7443CULL, 720, 236 },
+            { 0xBB764C4CA7A44410ULL, 747, 244 }, { 0x8BAB8EEFB6409C1AULL, 774, 252 },
+            { 0xD01FEF10A657842CULL, 800, 260 }, { 0x9B10A4E5E9913129ULL, 827, 268 },
+            { 0xE7109BFBA19C0C9DULL, 853, 276 }, { 0xAC2820D9623BF429ULL, 880, 284 },
+            { 0x80444B5E7AA7CF85ULL, 907, 292 }, { 0xBF21E44003ACDD2DULL, 933, 300 },
+            { 0x8E679C2F5E44FF8FULL, 960, 308 }, { 0xD433179D9C8CB841ULL, 986, 316 },
+            { 0x9E19DB92B4E31BA9ULL, 1013, 324 },
+        };
+        return CACHED_POWERS[idx];
+    }
+
+    // The cached power c = 10^-k for which the binary exponent of w * c lies in [-60, -32].
+    static const CachedPower& cached_power_for_binary_exponent(int e) {
+        int f = -61 - e;
+        int k = f * 78913 / (1 << 18) + (f > 0); // ceil(f * log10(2))
+        return cached_power((300 + k + 7) / 8);
+    }
+
+    // Grisu2 for a positive finite value: digits * 10^decimal_exponent is the shortest (in all but rare cases)
+    // decimal representation within the value's rounding interval.
+    static void grisu2(double value, char* digits, int& n_digits, int& decimal_exponent) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        uint64_t biased_exponent = bits >> 52, fraction = bits & ((1ULL << 52) - 1);
+        DiyFp v = biased_exponent == 0 ? DiyFp(fraction, -1074) : DiyFp(fraction | 1ULL << 52, (int) biased_exponent - 1075);
+
+        // Boundaries halfway to the neighbouring doubles. The lower one is closer when the fraction is zero.
+        DiyFp m_plus = normalize(DiyFp(2 * v.f + 1, v.e - 1));
+        DiyFp m_minus = fraction == 0 && biased_exponent > 1 ? DiyFp(4 * v.f - 1, v.e - 2) : DiyFp(2 * v.f - 1, v.e - 1);
+        m_minus = DiyFp(m_minus.f << (m_minus.e - m_plus.e), m_plus.e);
+        v = normalize(v);
+
+        const CachedPower& cached = cached_power_for_binary_exponent(m_plus.e);
+        DiyFp c(cached.f, cached.e);
+        DiyFp w = multiply(v, c);
+        DiyFp w_minus = multiply(m_minus, c);
+        DiyFp w_plus = multiply(m_plus, c);
+        // Shrink the interval by one unit on both sides to account for the multiplication errors.
+        w_minus.f += 1;
+        w_plus.f -= 1;
+
+        decimal_exponent = -cached.k;
+        n_digits = 0;
+        generate_digits(digits, n_digits, decimal_exponent, w_minus, w, w_plus);
+    }
+
+    static void generate_digits(char* digits, int& n_digits, int& decimal_exponent, const DiyFp& m_minus, const DiyFp& w, const DiyFp& m_plus) {
+        uint64_t delta = m_plus.f - m_minus.f;
+        uint64_t dist = m_plus.f - w.f;
+        int shift = -m_plus.e;
+        uint64_t one = 1ULL << shift;
+
+        // Integral and fractional parts of m_plus.
+        uint32_t p1 = (uint32_t) (m_plus.f >> shift);
+        uint64_t p2 = m_plus.f & (one - 1);
+
+        uint32_t pow10 = 1;
+        int n = 1;
+        while (n < 10 && p1 / pow10 >= 10) {
+            pow10 *= 10;
+            ++n;
+        }
+        while (n > 0) {
+            digits[n_digits++] = '0' + p1 / pow10;
+            p1 %= pow10;
+            --n;
+            uint64_t rest = ((uint64_t) p1 << shift) + p2;
+            if (rest <= delta) {
+                decimal_exponent += n;
+                round_last_digit(digits, n_digits, dist, delta, rest, (uint64_t) pow10 << shift);
+                return;
+            }
+            pow10 /= 10;
+        }
+
+        int m = 0;
+        for (;;) {
+            p2 *= 10;
+            digits[n_digits++] = '0' + (p2 >> shift);
+            p2 &= one - 1;
+            ++m;
+            delta *= 10;
+            dist *= 10;
+            if (p2 <= delta) break;
+        }
+        decimal_exponent -= m;
+        round_last_digit(digits, n_digits, dist, delta, p2, one);
+    }
+
+    // Move the last digit towards w while staying within the interval.
+    static void round_last_digit(char* digits, int n_digits, uint64_t dist, uint64_t delta, uint64_t rest, uint64_t ten_k) {
+        while (rest < dist && delta - rest >= ten_k && (rest + ten_k < dist || dist - rest > rest + ten_k - dist)) {
+            --digits[n_digits - 1];
+            rest += ten_k;
+        }
+    }
+
+};
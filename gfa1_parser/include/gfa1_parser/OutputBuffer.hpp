@@ -0,0 +1,180 @@
+/*
+    Buffered writer for the text output files. Text and numbers are formatted straight into a large buffer that is
+    written out in one call when full, instead of going through a stream one field at a time.
+    With a background flush, full buffers are handed to a separate thread that writes them while the next buffer fills up.
+    The output can also be appended to a string, e.g. for building a block that is written elsewhere.
+*/
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "BlockingQueue.hpp"
+#include "NumberFormat.hpp"
+
+class OutputBuffer {
+public:
+    OutputBuffer()
+    : m_file(nullptr),
+      m_target(nullptr),
+      m_capacity(FILE_BUFFER_SIZE),
+      m_size(0),
+      m_position(0),
+      m_error(false),
+      m_full(N_FLUSH_BUFFERS),
+      m_free(N_FLUSH_BUFFERS)
+    { }
+    // Append the output to target.
+    explicit OutputBuffer(std::string& target) : OutputBuffer() {
+        m_target = &target;
+        m_capacity = STRING_BUFFER_SIZE;
+        m_buffer.reset(new char[m_capacity]);
+    }
+    OutputBuffer(const OutputBuffer& other) = delete;
+    OutputBuffer& operator=(const OutputBuffer& other) = delete;
+    ~OutputBuffer() { close(); }
+
+    bool open(const std::string& filename, bool background_flush = false) {
+        m_file = std::fopen(filename.c_str(), "wb");
+        if (m_file == nullptr) return false;
+        m_buffer.reset(new char[m_capacity]);
+        if (background_flush) {
+            for (int i = 0; i < N_FLUSH_BUFFERS; ++i) m_free.push(std::unique_ptr<char[]>(new char[m_capacity]));
+            m_flusher = std::thread(&OutputBuffer::flush_buffers, this);
+        }
+        return true;
+    }
+
+    bool is_open() const { return m_file != nullptr || m_target != nullptr; }
+
+    bool good() const { return !m_error; }
+
+    // Number of bytes written so far.
+    uint64_t position() const { return m_position + m_size; }
+
+    OutputBuffer& put(char c) {
+        if (m_size == m_capacity) flush_buffer();
+        m_buffer[m_size++] = c;
+        return *this;
+    }
+
+    OutputBuffer& write(const char* data, std::size_t size) {
+        while (m_size + size > m_capacity) {
+            std::size_t n_copy = m_capacity - m_size;
+            std::memcpy(m_buffer.get() + m_size, data, n_copy);
+            m_size += n_copy;
+            data += n_copy;
+            size -= n_copy;
+            flush_buffer();
+        }
+        std::memcpy(m_buffer.get() + m_size, data, size);
+        m_size += size;
+        return *this;
+    }
+
+    OutputBuffer& operator<<(char c) { return put(c); }
+    OutputBuffer& operator<<(const char* str) { return write(str, std::strlen(str)); }
+    OutputBuffer& operator<<(const std::string& str) { return write(str.data(), str.size()); }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, OutputBuffer&>::type operator<<(T value) {
+        reserve_number();
+        char* begin = m_buffer.get() + m_size;
+        char* end = std::is_signed<T>::value ? NumberFormat::format_int(value, begin) : NumberFormat::format_uint(value, begin);
+        m_size += end - begin;
+        return *this;
+    }
+
+    OutputBuffer& operator<<(double value) {
+        reserve_number();
+        char* begin = m_buffer.get() + m_size;
+        m_size += NumberFormat::format_double(value, begin) - begin;
+        return *this;
+    }
+
+    // Write out everything buffered so far, waiting for the background flush to catch up.
+    void flush() {
+        if (!is_open()) return;
+        flush_buffer();
+        if (m_flusher.joinable()) {
+            // Wait until all buffers have been returned and put them back.
+            std::vector<std::unique_ptr<char[]>> buffers(N_FLUSH_BUFFERS);
+            for (auto& buffer : buffers) m_free.pop(buffer);
+            for (auto& buffer : buffers) m_free.push(std::move(buffer));
+        }
+        if (m_file != nullptr && std::fflush(m_file) != 0) m_error = true;
+    }
+
+    // Returns false if anything failed to be written.
+    bool close() {
+        if (!is_open()) return good();
+        flush_buffer();
+        if (m_flusher.joinable()) {
+            m_full.close();
+            m_flusher.join();
+        }
+        if (m_file != nullptr && std::fclose(m_file) != 0) m_error = true;
+        m_file = nullptr;
+        m_target = nullptr;
+        m_buffer.reset();
+        return good();
+    }
+
+private:
+    enum { FILE_BUFFER_SIZE = 4 * 1024 * 1024, STRING_BUFFER_SIZE = 64 * 1024, N_FLUSH_BUFFERS = 2 };
+
+    std::FILE* m_file;
+    std::string* m_target;
+
+    std::unique_ptr<char[]> m_buffer;
+    std::size_t m_capacity;
+    std::size_t m_size;
+    uint64_t m_position; // Bytes written before the current buffer.
+
+    std::atomic<bool> m_error;
+
+    // Background flush: full buffers are passed to the flusher thread, which returns them once written.
+    std::thread m_flusher;
+    BlockingQueue<std::pair<std::unique_ptr<char[]>, std::size_t>> m_full;
+    BlockingQueue<std::unique_ptr<char[]>> m_free;
+
+    void reserve_number() {
+        if (m_size + NumberFormat::MAX_LENGTH > m_capacity) flush_buffer();
+    }
+
+    void flush_buffer() {
+        if (m_size == 0) return;
+        if (m_flusher.joinable()) {
+            std::unique_ptr<char[]> buffer;
+            m_full.push(std::make_pair(std::move(m_buffer), m_size));
+            m_free.pop(buffer);
+            m_buffer = std::move(buffer);
+        } else {
+            write_out(m_buffer.get(), m_size);
+        }
+        m_position += m_size;
+        m_size = 0;
+    }
+
+    void write_out(const char* data, std::size_t size) {
+        if (m_target != nullptr) m_target->append(data, size);
+        else if (std::fwrite(data, 1, size, m_file) != size) m_error = true;
+    }
+
+    void flush_buffers() {
+        std::pair<std::unique_ptr<char[]>, std::size_t> buffer;
+        while (m_full.pop(buffer)) {
+            write_out(buffer.first.get(), buffer.second);
+            m_free.push(std::move(buffer.first));
+        }
+    }
+
+};
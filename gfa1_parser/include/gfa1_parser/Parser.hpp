@@ -3,133 +3,263 @@
 */
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <fstream>
+#include <functional>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "gfa1_parser.hpp"
 
+#include "BinaryGraphWriter.hpp"
+#include "Block.hpp"
 #include "Errors.hpp"
-#include "LineData.hpp"
 #include "LinkEndpoint.hpp"
 #include "Links.hpp"
+#include "OutputBuffer.hpp"
+#include "PackedPaths.hpp"
 #include "PathData.hpp"
 #include "Paths.hpp"
+#include "PresenceMatrix.hpp"
 #include "Segments.hpp"
-
-using line_data_t = LineData;
-using line_data_container_t = std::vector<line_data_t>;
+#include "StringView.hpp"
 
 class Parser {
 public:
-    Parser(Segments& segments, Links& links, Paths& paths, PathData& path_data, Errors& errors) 
+    Parser(Segments& segments, Links& links, Paths& paths, PathData& path_data, Errors& errors, std::size_t n_threads = 1, bool grouped_paths = false)
       : m_segments(segments),
         m_links(links),
         m_paths(paths),
         m_path_data(path_data),
-        m_errors(errors)
+        m_errors(errors),
+        m_n_threads(std::max<std::size_t>(n_threads, 1)),
+        m_grouped_paths(grouped_paths),
+        m_n_finished_paths(0),
+        m_presence_matrix(nullptr),
+        m_packed_paths(nullptr),
+        m_binary_paths(false),
+        m_write_path_files(false),
+        m_tilings(false),
+        m_tiling_overlap(0),
+        m_max_batch_memory(0)
     { }
 
-    bool process_segment_line_data(line_data_container_t& segment_line_data) {
-        for (auto& line_data : segment_line_data) {
-            auto& fields = line_data.fields();
-            if (fields.size() < 3) {
-                m_errors.report("Segment line has incorrect format.", line_data.line_number());
-                return false;
-            }
+    // Open the output files for the paths. Must be called before processing any path. The paths file isn't needed with packed paths.
+    bool open_path_files(const std::string& fasta_filename, const std::string& paths_filename, const std::string& path_directory) {
+        m_path_directory = path_directory;
+        m_write_path_files = true;
+        // The FASTA file grows by a full row of the unitigs for every path, so it's written in the background.
+        return m_out_fasta.open(fasta_filename, true) && (m_packed_paths || m_out_paths.open(paths_filename));
+    }
+
+    // Finish writing the fasta and paths files. Returns false if anything failed to be written.
+    bool close_path_files() {
+        bool fasta_ok = m_out_fasta.close();
+        return m_out_paths.close() && fasta_ok;
+    }
+
+    // Also add a row to the presence/absence matrix for each path.
+    void set_presence_matrix(PresenceMatrix& presence_matrix) { m_presence_matrix = &presence_matrix; }
+
+    // Write the edges of each path to a single container instead of one file per path, as binary graphs if binary is set.
+    // Must be called before open_path_files().
+    void set_packed_paths(PackedPaths& packed_paths, bool binary = false) {
+        m_packed_paths = &packed_paths;
+        m_binary_paths = binary;
+    }
+
+    // The path lines are Cuttlefish's sequence tilings: space-separated segment names without overlaps, each overlapping the next by overlap.
+    void set_tilings(uint64_t overlap) {
+        m_tilings = true;
+        m_tiling_overlap = overlap;
+    }
 
-            std::string&& name = std::move(fields[1]);
-            std::string&& sequence = std::move(fields[2]);
-
-            if (m_segments.contains(name)) {
-                auto& current_sequence = m_segments.sequence(name);
-                if (current_sequence.empty()) {
-                    // Name mapped previously by a link line, missing sequence given by this segment line.
-                    current_sequence = std::move(sequence);
-                } else if (current_sequence != sequence) {
-                    // Multiple segment lines for the same name.
-                    m_errors.report(std::string() + "Segment with name " + name + " has multiple sequences.", line_data.line_number());
+    /*
+        Continue a previous run whose state has been read into the containers. The previous run's FASTA entries, presence matrix rows and
+        paths file lines or packed paths are written before the paths of this run, with the segments added by this run absent.
+        Its references can't be given again.
+    */
+    void set_previous_run(const std::vector<std::string>& references, uint64_t n_segments, const std::string& fasta_filename,
+                          const std::string& paths_filename, const std::string& packed_paths_filename) {
+        m_previous_run.pending = true;
+        m_previous_run.references.insert(references.begin(), references.end());
+        m_previous_run.n_references = references.size();
+        m_previous_run.n_segments = n_segments;
+        m_previous_run.fasta_filename = fasta_filename;
+        m_previous_run.paths_filename = paths_filename;
+        m_previous_run.packed_paths_filename = packed_paths_filename;
+    }
+
+    // Within a memory budget, finish fewer paths at a time so that their FASTA entries and presence matrix rows take about
+    // max_bytes at most, but at least one path.
+    void set_max_batch_memory(uint64_t max_bytes) { m_max_batch_memory = max_bytes; }
+
+    // Number of paths finished at a time.
+    std::size_t batch_size() const {
+        std::size_t n_paths = 4 * m_n_threads;
+        if (m_max_batch_memory == 0) return n_paths;
+        uint64_t max_paths = m_max_batch_memory / path_output_bytes();
+        return max_paths == 0 ? 1 : std::min<uint64_t>(n_paths, max_paths);
+    }
+
+    // Also call f(path_idx, path) for each path once its links are compacted, e.g. to use it without the output files. Called by the worker threads.
+    void set_path_callback(std::function<bool(std::size_t, const Path&)> f) { m_path_callback = std::move(f); }
+
+    // Process the records of a parsed block: all segments first, then links and then paths, as in the serial parser.
+    // Segment ids are assigned as if this was done for each group of blocks at once, see Block::ends_group().
+    bool process_block(Block& block) {
+        auto& records = block.records();
+        if (m_n_finished_paths > 0) {
+            // In grouped mode, finished paths were written with the segments known at the time.
+            for (auto& block_records : records) {
+                uint64_t line_number = !block_records.segments.empty() ? block_records.segments[0].line_number
+                                     : !block_records.links.empty() ? block_records.links[0].line_number : 0;
+                if (line_number > 0) {
+                    m_errors.report("Segment and link lines must precede path lines with grouped paths", line_number);
                     return false;
                 }
-            } else {
-                m_segments.map_name_and_sequence(std::move(name), std::move(sequence));
             }
         }
+        for (auto& block_records : records) if (!process_segment_records(block_records.segments)) return false;
+        for (auto& block_records : records) if (!process_link_records(block_records.links)) return false;
+        if (block.ends_group() && !process_deferred_links()) return false;
+        for (auto& block_records : records) if (!process_path_records(block_records.paths)) return false;
         return true;
     }
 
-    bool process_link_line_data(line_data_container_t& link_line_data) {
-        for (auto& line_data : link_line_data) {
-            auto& fields = line_data.fields();
-            if (fields.size() < 6) {
-                m_errors.report("Link line has incorrect format.", line_data.line_number());
+    bool process_segment_records(const std::vector<SegmentRecord>& segment_records) {
+        for (const auto& record : segment_records) {
+            uint64_t mapped_idx = m_segments.find(record.name);
+            if (mapped_idx == Segments::NOT_FOUND) {
+                m_segments.map_name_and_sequence(record.name, record.sequence);
+            } else if (!m_segments.has_sequence(mapped_idx)) {
+                // Name mapped previously by a link line, missing sequence given by this segment line.
+                m_segments.set_sequence(mapped_idx, record.sequence);
+            } else if (!m_segments.sequence_equals(mapped_idx, record.sequence)) {
+                // Multiple segment lines for the same name.
+                m_errors.report(std::string() + "Segment with name " + record.name.to_string() + " has multiple sequences.", record.line_number);
                 return false;
             }
-
-            std::string& from = fields[1];
-            char from_orient = fields[2][0];
-            std::string& to = fields[3];
-            char to_orient = fields[4][0];
-            uint64_t overlap = std::stoull(fields[5]);
-
-            uint64_t from_id = m_segments.contains(from) ? m_segments.mapped_idx(from) : m_segments.map_name(std::move(from));
-            uint64_t to_id = m_segments.contains(to) ? m_segments.mapped_idx(to) : m_segments.map_name(std::move(to));
-
-            m_links.add_link(from_id, to_id, from_orient, to_orient, overlap);
         }
         return true;
     }
 
-    bool process_path_line_data(line_data_container_t& path_line_data) {
-        for (auto& line_data : path_line_data) {
-            auto& fields = line_data.fields();
+    // Links to segments that haven't been mapped yet are deferred to the end of the group, since a later segment line of the
+    // group would map them first.
+    bool process_link_records(const std::vector<LinkRecord>& link_records) {
+        for (const auto& record : link_records) {
+            uint64_t from_id = m_segments.find(record.from);
+            uint64_t to_id = m_segments.find(record.to);
+            if (from_id == Segments::NOT_FOUND || to_id == Segments::NOT_FOUND) {
+                std::size_t names_begin = m_deferred_names.size();
+                m_deferred_names.append(record.from.data(), record.from.size());
+                m_deferred_names.append(record.to.data(), record.to.size());
+                m_deferred_links.push_back({ names_begin, record.from.size(), record.to.size(), record.overlap, record.line_number,
+                                             record.from_orient, record.to_orient });
+            } else if (!add_link(from_id, to_id, record.from_orient, record.to_orient, record.overlap, record.line_number)) {
+                return false;
+            }
+        }
+        return true;
+    }
 
-            const std::string& pathname = fields.at(1);
+    // Map the segment names of the deferred links in line order, as if they were processed after all segments of the group.
+    bool process_deferred_links() {
+        for (const auto& link : m_deferred_links) {
+            const char* from_name = m_deferred_names.data() + link.names_begin;
+            const char* to_name = from_name + link.from_size;
+            uint64_t from_id = m_segments.map_name(StringView(from_name, link.from_size));
+            uint64_t to_id = m_segments.map_name(StringView(to_name, link.to_size));
+            if (!add_link(from_id, to_id, link.from_orient, link.to_orient, link.overlap, link.line_number)) return false;
+        }
+        gfa1_parser::clear(m_deferred_links);
+        gfa1_parser::clear(m_deferred_names);
+        return true;
+    }
 
-            std::string reference, sequence;
-            std::tie(reference, sequence) = m_paths.parse_cuttlefish_reference_and_sequence(pathname);
-            if (reference.empty() && sequence.empty()) {
-                m_errors.report("Failed to parse path name", line_data.line_number());
+    bool process_path_records(std::vector<PathRecord>& path_records) {
+        for (auto& record : path_records) {
+            if (!m_previous_run.references.empty() && m_previous_run.references.count(record.reference)) {
+                m_errors.report("Reference " + record.reference + " was already added by the previous run", record.line_number);
+                return false;
+            }
+            uint64_t path_idx = m_paths.contains(record.reference) ? m_paths.mapped_idx(record.reference)
+                                                                    : m_paths.add_path(std::move(record.reference), std::move(record.sequence));
+            if (m_grouped_paths && path_idx != m_path_data.n_paths() - 1) {
+                // Paths are mapped in order of appearance, so the previous path is complete once a new one starts.
+                if (path_idx < m_path_data.n_paths()) {
+                    m_errors.report("Path lines for reference " + m_paths[path_idx].reference() + " are not grouped together", record.line_number);
+                    return false;
+                }
+                if (path_idx - m_n_finished_paths >= batch_size() && !(process_deferred_links() && finish_paths(m_n_finished_paths, path_idx))) return false;
+            }
+            if (!m_path_data.add_path_data(path_idx, std::move(record.segment_names), std::move(record.overlaps))) {
+                m_errors.report("Failed to spill the path lines to disk", record.line_number);
                 return false;
             }
-
-            uint64_t path_idx = m_paths.contains(reference) ? m_paths.mapped_idx(reference) : m_paths.add_path(std::move(reference), std::move(sequence));
-            m_path_data.add_path_data(path_idx, std::move(fields.at(2)), std::move(fields.at(3)));
         }
         return true;
     }
 
-    bool process_paths(const std::string& fasta_filename, const std::string& paths_filename, const std::string& path_directory) {    
-        std::ofstream ofs_fasta(fasta_filename);    
-        std::ofstream ofs_paths(paths_filename);
+    // Process the paths that haven't been finished yet.
+    bool process_paths() {
+        if (m_previous_run.pending && !write_previous_run()) return false;
         std::size_t n_paths = m_path_data.n_paths();
         auto time_path_loop_start = gfa1_parser::time_now();
-        for (std::size_t path_idx = 0; path_idx < m_path_data.n_paths(); ++path_idx) {
-            Path& path = m_paths[path_idx];
-            path.set_capacity(m_paths.n_segments());
-
-            if (!process_path(path_idx)) return false;
-            m_paths.add_counts(path.counts());
-            
-            m_paths.write_to_fasta(ofs_fasta, path);
-            
-            const std::string& path_edges_filename = path_directory + "/" + path.reference() + ".edges";
-            path.write_links(path_edges_filename);
-
-            const std::string& path_counts_filename = path_directory + "/" + path.reference() + ".counts";
-            path.write_counts(path_counts_filename);
+        while (m_n_finished_paths < n_paths) {
+            if (!finish_paths(m_n_finished_paths, std::min(m_n_finished_paths + batch_size(), n_paths))) return false;
+            std::cout << "\rProcessed paths " << m_n_finished_paths << '/' << n_paths 
+                      << ". Time elapsed: " << gfa1_parser::time_elapsed(time_path_loop_start) << '.' << std::flush;
+        }
+        std::cout << "\rProcessed paths " << n_paths << '/' << n_paths 
+                  << ". Time elapsed: " << gfa1_parser::time_elapsed(time_path_loop_start) << '.' << std::endl;
+        return true;
+    }
 
-            ofs_paths << path_edges_filename << '\n';
+    // Process complete paths [path_idx_begin, path_idx_end) in parallel. The FASTA entries and the paths file are written in order afterwards.
+    // Batches of paths must be finished in order.
+    bool finish_paths(std::size_t path_idx_begin, std::size_t path_idx_end) {
+        if (m_previous_run.pending && !write_previous_run()) return false;
+        m_paths.set_n_segments(m_segments.size());
+        for (std::size_t path_idx = path_idx_begin; path_idx < path_idx_end; ++path_idx) {
+            if (!m_path_data.load(path_idx)) {
+                m_errors.report("Failed to read back the spilled path lines of path with internal index " + std::to_string(path_idx));
+                return false;
+            }
+        }
+        std::vector<std::string> fasta_entries(path_idx_end - path_idx_begin);
+        std::vector<std::vector<unsigned char>> presence_rows(m_presence_matrix ? fasta_entries.size() : 0);
+        std::vector<std::string> edge_blocks(m_packed_paths ? fasta_entries.size() : 0);
+        std::atomic<std::size_t> next_path_idx(path_idx_begin);
+        std::atomic<bool> ok(true);
+        auto worker = [&]() {
+            for (std::size_t path_idx = next_path_idx++; ok && path_idx < path_idx_end; path_idx = next_path_idx++) {
+                std::size_t idx = path_idx - path_idx_begin;
+                if (!finish_path(path_idx, fasta_entries[idx], m_presence_matrix ? &presence_rows[idx] : nullptr,
+                                 m_packed_paths ? &edge_blocks[idx] : nullptr)) ok = false;
+            }
+        };
+        std::vector<std::thread> threads;
+        for (std::size_t thr = 0; thr < std::min(m_n_threads, path_idx_end - path_idx_begin); ++thr) threads.emplace_back(worker);
+        for (auto& thr : threads) thr.join();
+        if (!ok) return false;
 
+        for (std::size_t path_idx = path_idx_begin; path_idx < path_idx_end; ++path_idx) {
+            if (m_write_path_files) {
+                m_out_fasta << fasta_entries[path_idx - path_idx_begin];
+                if (m_packed_paths) m_packed_paths->add_block(m_paths[path_idx].reference(), edge_blocks[path_idx - path_idx_begin]);
+                else m_out_paths << path_edges_filename(m_paths[path_idx]) << '\n';
+            }
+            if (m_presence_matrix) m_presence_matrix->add_row(presence_rows[path_idx - path_idx_begin], m_paths.n_segments());
             m_path_data.clear(path_idx);
-            path.clear();
-
-            if ((path_idx + 1) % 10 == 0) std::cout << "\rProcessed paths " << path_idx + 1 << '/' << n_paths 
-                                                    << ". Time elapsed: " << gfa1_parser::time_elapsed(time_path_loop_start) << '.' << std::flush;
         }
-        std::cout << "\rProcessed paths " << n_paths << '/' << n_paths 
-                  << ". Time elapsed: " << gfa1_parser::time_elapsed(time_path_loop_start) << '.' << std::endl;
+        m_n_finished_paths = path_idx_end;
         return true;
     }
 
@@ -141,32 +271,169 @@ private:
 
     Errors& m_errors;
 
-    bool process_path(std::size_t path_idx) {
-        Path& path = m_paths[path_idx];
-        if (path.capacity() == 0) {
-            m_errors.report("Path with internal index " + std::to_string(path_idx) + " capacity not set (is zero)");
+    std::size_t m_n_threads;
+    bool m_grouped_paths;
+    std::size_t m_n_finished_paths;
+
+    OutputBuffer m_out_fasta;
+    OutputBuffer m_out_paths;
+    std::string m_path_directory;
+    PresenceMatrix* m_presence_matrix;
+    PackedPaths* m_packed_paths;
+    bool m_binary_paths;
+    bool m_write_path_files;
+    bool m_tilings;
+    uint64_t m_tiling_overlap;
+    std::function<bool(std::size_t, const Path&)> m_path_callback;
+    uint64_t m_max_batch_memory;
+
+    struct DeferredLink {
+        std::size_t names_begin; // The from and to names follow each other in m_deferred_names.
+        std::size_t from_size;
+        std::size_t to_size;
+        uint64_t overlap;
+        uint64_t line_number;
+        char from_orient;
+        char to_orient;
+    };
+    std::vector<DeferredLink> m_deferred_links;
+    std::string m_deferred_names;
+
+    struct PreviousRun {
+        bool pending = false;
+        std::unordered_set<std::string> references;
+        uint64_t n_references = 0;
+        uint64_t n_segments = 0;
+        std::string fasta_filename;
+        std::string paths_filename;
+        std::string packed_paths_filename;
+    } m_previous_run;
+
+    // Memory that the outputs of a path take until its batch is written: a FASTA entry with a character for each segment and
+    // a presence matrix row with a bit for each segment.
+    uint64_t path_output_bytes() const {
+        uint64_t n_segments = m_segments.size();
+        return 1 + (m_write_path_files ? n_segments : 0) + (m_presence_matrix ? (n_segments + 7) / 8 : 0);
+    }
+
+    bool add_link(uint64_t from_id, uint64_t to_id, char from_orient, char to_orient, uint64_t overlap, uint64_t line_number) {
+        if (m_links.add_link(from_id, to_id, from_orient, to_orient, overlap)) return true;
+        m_errors.report(m_links.spill_failed() ? "Failed to spill the links to disk" : "Too many distinct link overlaps", line_number);
+        return false;
+    }
+
+    // Write the previous run's paths, reading their occurrence patterns back from its FASTA file.
+    bool write_previous_run() {
+        m_previous_run.pending = false;
+        m_paths.set_n_segments(m_segments.size());
+        std::ifstream ifs_fasta(m_previous_run.fasta_filename);
+        std::string line, sequence, pattern;
+        uint64_t n_references = 0;
+        bool in_entry = false;
+        auto write_entry = [&]() {
+            if (pattern.size() != m_previous_run.n_segments) return false;
+            if (m_write_path_files) m_out_fasta << m_paths.fasta_entry(sequence, pattern);
+            if (m_presence_matrix) m_presence_matrix->add_row(PresenceMatrix::row(pattern, m_paths.n_segments()), m_paths.n_segments());
+            ++n_references;
+            return true;
+        };
+        while (std::getline(ifs_fasta, line)) {
+            if (line.empty() || line[0] != '>') {
+                pattern += line;
+                continue;
+            }
+            if (in_entry && !write_entry()) break;
+            in_entry = true;
+            sequence = line.substr(1);
+            pattern.clear();
+        }
+        if (in_entry && ifs_fasta.eof()) write_entry();
+        if (n_references != m_previous_run.n_references) {
+            m_errors.report("The previous run's " + m_previous_run.fasta_filename + " doesn't match its state");
             return false;
         }
+        if (!m_write_path_files) return true;
+
+        if (m_packed_paths) {
+            if (!m_packed_paths->add_blocks(m_previous_run.packed_paths_filename) || m_packed_paths->n_blocks() != n_references) {
+                m_errors.report("Failed to read the previous run's packed paths from " + m_previous_run.packed_paths_filename);
+                return false;
+            }
+            return true;
+        }
+        // The paths file lines of the previous run point to its own path directory.
+        std::ifstream ifs_paths(m_previous_run.paths_filename);
+        uint64_t n_lines = 0;
+        for (; std::getline(ifs_paths, line); ++n_lines) m_out_paths << line << '\n';
+        if (n_lines != n_references) {
+            m_errors.report("The previous run's " + m_previous_run.paths_filename + " doesn't match its state");
+            return false;
+        }
+        return true;
+    }
+
+    std::string path_edges_filename(const Path& path) const { return m_path_directory + "/" + path.reference() + ".edges"; }
+    std::string path_counts_filename(const Path& path) const { return m_path_directory + "/" + path.reference() + ".counts"; }
+
+    // Process a complete path and write its own output files if they were opened. Called by the worker threads.
+    bool finish_path(std::size_t path_idx, std::string& fasta_entry, std::vector<unsigned char>* presence_row, std::string* edge_block) {
+        Path& path = m_paths[path_idx];
+        if (!process_path(path_idx)) return false;
+        path.compact();
+        m_paths.add_counts(path.counts());
+        if (m_path_callback && !m_path_callback(path_idx, path)) return false;
+
+        if (presence_row) *presence_row = PresenceMatrix::row(path, m_paths.n_segments());
+        if (!m_write_path_files) {
+            path.clear();
+            return true;
+        }
+        fasta_entry = m_paths.fasta_entry(path);
+        if (edge_block && m_binary_paths) {
+            std::ostringstream oss;
+            BinaryGraphWriter binary_graph(oss);
+            path.write_links(binary_graph);
+            binary_graph.finish();
+            *edge_block = oss.str();
+        } else if (edge_block) {
+            OutputBuffer out(*edge_block);
+            path.write_links(out);
+        } else {
+            // Packed paths replace all files in the path directory, the counts of each reference are only in the counts file.
+            path.write_links(path_edges_filename(path));
+            path.write_counts(path_counts_filename(path));
+        }
+
+        path.clear();
+        return true;
+    }
+
+    bool process_path(std::size_t path_idx) {
+        Path& path = m_paths[path_idx];
+        std::vector<StringView> segment_names, overlaps;
+        std::vector<uint64_t> segment_ids;
+        std::vector<char> orients;
         for (std::size_t idx = 0; idx < m_path_data.n_path_lines(path_idx); ++idx) {
-            auto segment_names = gfa1_parser::get_fields(m_path_data.segment_names(path_idx, idx), ',');
+            gfa1_parser::get_fields(m_path_data.segment_names(path_idx, idx), segment_names, m_tilings ? ' ' : ',');
             if (segment_names.size() == 1) continue; // Path is a single unitig.
-            std::vector<uint64_t> segment_ids;
-            std::vector<char> orients;
-            for (auto& segment : segment_names) {
-                orients.push_back(segment.back());
-                segment.pop_back();
-                if (!m_segments.contains(segment)) {
+            segment_ids.clear();
+            orients.clear();
+            for (auto segment_name : segment_names) {
+                orients.push_back(segment_name.back());
+                segment_name.remove_suffix(1);
+                uint64_t segment_id = m_segments.find(segment_name);
+                if (segment_id == Segments::NOT_FOUND) {
                     m_errors.report("Path with internal index " + std::to_string(path_idx) + " contains an unmapped segment");
                     return false;
                 }
-                segment_ids.push_back(m_segments.mapped_idx(segment));
+                segment_ids.push_back(segment_id);
                 path.add_count(segment_ids.back());
             }
 
-            auto overlaps = gfa1_parser::get_fields(m_path_data.overlaps(path_idx, idx), ',');
+            gfa1_parser::get_fields(m_path_data.overlaps(path_idx, idx), overlaps, ',');
             // Check for a bug that existed in Cuttlefish <= 1.0.0.
             uint64_t index_correction = overlaps.size() == segment_ids.size();
-            if (segment_ids.size() - 1 + index_correction != overlaps.size()) {
+            if (!m_tilings && segment_ids.size() - 1 + index_correction != overlaps.size()) {
                 m_errors.report("Path with internal index " + std::to_string(path_idx) + " has wrong 'segment_ids' and 'overlaps' counts");
                 return false;
             }
@@ -175,9 +442,12 @@ private:
                 auto to_id = segment_ids[segment_idx];
                 char from_orient = orients[segment_idx - 1];
                 char to_orient = orients[segment_idx];
-                uint64_t overlap = std::stoull(overlaps[segment_idx - 1 + index_correction]);
+                uint64_t overlap = m_tilings ? m_tiling_overlap : gfa1_parser::to_uint64(overlaps[segment_idx - 1 + index_correction]);
 
-                path.add_link(from_id, to_id, from_orient, to_orient, overlap);
+                if (!path.add_link(from_id, to_id, from_orient, to_orient, overlap)) {
+                    m_errors.report("Path with internal index " + std::to_string(path_idx) + " has too many distinct overlaps");
+                    return false;
+                }
             }
         }
         return true;
@@ -185,4 +455,3 @@ private:
 
 };
 
-
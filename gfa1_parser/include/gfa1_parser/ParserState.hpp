@@ -0,0 +1,144 @@
+/*
+    State of a run, written with '-s', that a later run can add genome references to with '-i'.
+    It holds what can't be recovered from the output files: the segment names in id order, the links, the counts above 1
+    and the references in FASTA order. The sequences and the outputs of the references are read from the previous run's output files.
+
+    State file layout (all integers are 64-bit little-endian words):
+        magic "GFA1STA\0", version, n_segments, n_links, n_counts, n_references,
+        n_segments names in id order, each as its length followed by its bytes,
+        n_links link records of from_id, to_id and overlap << 2 | edge type (FF, FR, RF and RR are 0, 1, 2 and 3),
+        n_counts count records of id and count,
+        n_references reference names, each as its length followed by its bytes.
+*/
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Links.hpp"
+#include "Paths.hpp"
+#include "Segments.hpp"
+
+class ParserState {
+public:
+    enum { VERSION = 1 };
+
+    ParserState() : m_n_segments(0) { }
+
+    // References of the previous run in FASTA order.
+    const std::vector<std::string>& references() const { return m_references; }
+
+    // Number of segments in the previous run.
+    uint64_t n_segments() const { return m_n_segments; }
+
+    /*
+        Read a previous run's state into the empty containers, so that its segments keep their ids. The sequences are
+        read from the previous unitigs file, which must be the first thing written to the segments' unitigs file.
+    */
+    bool read(const std::string& state_filename, const std::string& unitigs_filename, Segments& segments, Links& links, Paths& paths) {
+        std::ifstream ifs(state_filename, std::ios::binary);
+        char magic[sizeof(MAGIC)];
+        if (!ifs.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), MAGIC) || read_word(ifs) != VERSION) return false;
+        m_n_segments = read_word(ifs);
+        uint64_t n_links = read_word(ifs);
+        uint64_t n_counts = read_word(ifs);
+        uint64_t n_references = read_word(ifs);
+
+        std::string name;
+        for (uint64_t idx = 0; ifs && idx < m_n_segments; ++idx) {
+            if (!read_string(ifs, name) || segments.contains(name)) return false;
+            segments.map_name_and_sequence(name, StringView());
+        }
+        for (uint64_t idx = 0; ifs && idx < n_links; ++idx) {
+            uint64_t from_id = read_word(ifs);
+            uint64_t to_id = read_word(ifs);
+            uint64_t word = read_word(ifs);
+            if (from_id >= m_n_segments || to_id >= m_n_segments) return false;
+            if (!links.add_link(from_id, to_id, word & 2 ? '-' : '+', word & 1 ? '-' : '+', word >> 2)) return false;
+        }
+        std::vector<std::pair<uint64_t, uint64_t>> counts;
+        for (uint64_t idx = 0; ifs && idx < n_counts; ++idx) {
+            uint64_t id = read_word(ifs);
+            if (id >= m_n_segments) return false;
+            counts.emplace_back(id, read_word(ifs));
+        }
+        paths.set_n_segments(m_n_segments);
+        paths.add_counts(counts);
+        m_references.resize(n_references);
+        for (auto& reference : m_references) {
+            if (!read_string(ifs, reference)) return false;
+        }
+        return ifs && segments.read_sequences(unitigs_filename);
+    }
+
+    // Write the state after this run: the previous run's references come first, followed by the paths of this run.
+    bool write_out(const std::string& out_filename, const Segments& segments, Links& links, const Paths& paths) const {
+        std::ofstream ofs(out_filename, std::ios::binary);
+        if (!links.compact()) return false;
+        uint64_t n_counts = 0;
+        for (uint64_t idx = 0; idx < paths.n_segments(); ++idx) n_counts += paths.count(idx) > 1;
+        ofs.write(MAGIC, sizeof(MAGIC));
+        write_word(ofs, VERSION);
+        write_word(ofs, segments.size());
+        write_word(ofs, links.n_links());
+        write_word(ofs, n_counts);
+        write_word(ofs, m_references.size() + paths.size());
+        for (uint64_t idx = 0; idx < segments.size(); ++idx) write_string(ofs, segments.idx_to_gfa1_name(idx));
+        bool links_ok = links.for_each_link([&ofs](uint64_t from_id, uint64_t to_id, uint64_t edge_type, uint64_t overlap) {
+            write_word(ofs, from_id);
+            write_word(ofs, to_id);
+            write_word(ofs, overlap << 2 | edge_type);
+        });
+        if (!links_ok) return false;
+        for (uint64_t idx = 0; idx < paths.n_segments(); ++idx) {
+            if (paths.count(idx) <= 1) continue;
+            write_word(ofs, idx);
+            write_word(ofs, paths.count(idx));
+        }
+        for (const auto& reference : m_references) write_string(ofs, reference);
+        for (std::size_t path_idx = 0; path_idx < paths.size(); ++path_idx) write_string(ofs, paths[path_idx].reference());
+        ofs.close();
+        return !ofs.fail();
+    }
+
+private:
+    static constexpr char MAGIC[8] = {'G', 'F', 'A', '1', 'S', 'T', 'A', '\0'};
+    static constexpr uint64_t MAX_STRING_SIZE = 1ULL << 32;
+
+    uint64_t m_n_segments;
+    std::vector<std::string> m_references;
+
+    static void write_word(std::ofstream& ofs, uint64_t word) {
+        char bytes[8];
+        for (int i = 0; i < 8; ++i) bytes[i] = (word >> (8 * i)) & 0xff;
+        ofs.write(bytes, 8);
+    }
+
+    static uint64_t read_word(std::ifstream& ifs) {
+        unsigned char bytes[8] = {};
+        ifs.read(reinterpret_cast<char*>(bytes), 8);
+        uint64_t word = 0;
+        for (int i = 0; i < 8; ++i) word |= (uint64_t) bytes[i] << (8 * i);
+        return word;
+    }
+
+    static void write_string(std::ofstream& ofs, const std::string& str) {
+        write_word(ofs, str.size());
+        ofs.write(str.data(), str.size());
+    }
+
+    static bool read_string(std::ifstream& ifs, std::string& str) {
+        uint64_t size = read_word(ifs);
+        if (!ifs || size > MAX_STRING_SIZE) return false;
+        str.resize(size);
+        return static_cast<bool>(ifs.read(&str[0], size));
+    }
+
+};
+
+constexpr char ParserState::MAGIC[8];
+constexpr uint64_t ParserState::MAX_STRING_SIZE;
@@ -0,0 +1,147 @@
+/*
+    Machine-readable report of the program's phases, written as JSON with '-r'.
+    For each phase: wall and CPU time, the lines and bytes read or written with their rates, the peak resident set size
+    so far and the sizes of the containers when the phase ended.
+*/
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifndef WIN32
+#include <sys/resource.h>
+#endif
+
+#include "Links.hpp"
+#include "OutputBuffer.hpp"
+#include "PathData.hpp"
+#include "Segments.hpp"
+
+class PhaseReport {
+public:
+    PhaseReport(const Segments& segments, const Links& links, const PathData& path_data)
+    : m_segments(segments),
+      m_links(links),
+      m_path_data(path_data),
+      m_program_start(clock::now()),
+      m_program_cpu_start(cpu_microseconds())
+    { }
+
+    void begin_phase(const std::string& name) {
+        m_phases.emplace_back();
+        m_phases.back().name = name;
+        m_phase_start = clock::now();
+        m_phase_cpu_start = cpu_microseconds();
+    }
+
+    // End the current phase, which read or wrote n_lines lines and n_bytes bytes.
+    void end_phase(uint64_t n_lines, uint64_t n_bytes) {
+        Phase& phase = m_phases.back();
+        phase.wall_seconds = seconds_since(m_phase_start);
+        phase.cpu_seconds = (cpu_microseconds() - m_phase_cpu_start) / 1e6;
+        phase.n_lines = n_lines;
+        phase.n_bytes = n_bytes;
+        phase.peak_rss_bytes = peak_rss_bytes();
+        phase.n_segments = m_segments.size();
+        phase.n_links = m_links.n_links();
+        phase.n_path_lines = m_path_data.n_path_lines();
+    }
+
+    bool write_out(const std::string& out_filename, const std::string& gfa1_filename, int64_t n_threads) const {
+        OutputBuffer out;
+        if (!out.open(out_filename)) return false;
+        out << "{\n";
+        out << "  \"gfa1_file\": "; write_string(out, gfa1_filename); out << ",\n";
+        out << "  \"threads\": " << n_threads << ",\n";
+        out << "  \"wall_seconds\": " << seconds_since(m_program_start) << ",\n";
+        out << "  \"cpu_seconds\": " << (cpu_microseconds() - m_program_cpu_start) / 1e6 << ",\n";
+        out << "  \"peak_rss_bytes\": " << peak_rss_bytes() << ",\n";
+        out << "  \"phases\": [";
+        for (std::size_t idx = 0; idx < m_phases.size(); ++idx) {
+            const Phase& phase = m_phases[idx];
+            out << (idx ? ",\n" : "\n") << "    {\n";
+            out << "      \"name\": "; write_string(out, phase.name); out << ",\n";
+            out << "      \"wall_seconds\": " << phase.wall_seconds << ",\n";
+            out << "      \"cpu_seconds\": " << phase.cpu_seconds << ",\n";
+            out << "      \"lines\": " << phase.n_lines << ",\n";
+            out << "      \"lines_per_second\": " << rate(phase.n_lines, phase.wall_seconds) << ",\n";
+            out << "      \"bytes\": " << phase.n_bytes << ",\n";
+            out << "      \"mb_per_second\": " << rate(phase.n_bytes / 1e6, phase.wall_seconds) << ",\n";
+            out << "      \"peak_rss_bytes\": " << phase.peak_rss_bytes << ",\n";
+            out << "      \"segments\": " << phase.n_segments << ",\n";
+            out << "      \"links\": " << phase.n_links << ",\n";
+            out << "      \"path_lines\": " << phase.n_path_lines << "\n";
+            out << "    }";
+        }
+        out << "\n  ]\n}\n";
+        return out.close();
+    }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    struct Phase {
+        std::string name;
+        double wall_seconds = 0.0;
+        double cpu_seconds = 0.0;
+        uint64_t n_lines = 0;
+        uint64_t n_bytes = 0;
+        uint64_t peak_rss_bytes = 0;
+        uint64_t n_segments = 0;
+        uint64_t n_links = 0;
+        uint64_t n_path_lines = 0;
+    };
+
+    const Segments& m_segments;
+    const Links& m_links;
+    const PathData& m_path_data;
+
+    clock::time_point m_program_start;
+    uint64_t m_program_cpu_start;
+    clock::time_point m_phase_start;
+    uint64_t m_phase_cpu_start;
+
+    std::vector<Phase> m_phases;
+
+    static double seconds_since(const clock::time_point& tp) { return std::chrono::duration<double>(clock::now() - tp).count(); }
+
+    static double rate(double amount, double seconds) { return seconds > 0.0 ? amount / seconds : 0.0; }
+
+    // User and system time of all threads.
+    static uint64_t cpu_microseconds() {
+        #ifndef WIN32
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+        return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000ULL + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+        #else
+        return 0;
+        #endif
+    }
+
+    static uint64_t peak_rss_bytes() {
+        #ifndef WIN32
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+        #ifdef __APPLE__
+        return usage.ru_maxrss;
+        #else
+        return usage.ru_maxrss * 1024ULL; // Kilobytes on Linux.
+        #endif
+        #else
+        return 0;
+        #endif
+    }
+
+    static void write_string(OutputBuffer& out, const std::string& str) {
+        out << '"';
+        for (char c : str) {
+            if (c == '"' || c == '\\') out << '\\' << c;
+            else if ((unsigned char) c < 0x20) out << "\\u00" << "0123456789abcdef"[c >> 4] << "0123456789abcdef"[c & 15];
+            else out << c;
+        }
+        out << '"';
+    }
+
+};
@@ -0,0 +1,193 @@
+/*
+    A command line argument handler class.
+*/
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "MemoryBudget.hpp"
+
+class ProgramOptions {
+public:
+    static void read_command_line_arguments(int ac, char** av) {
+        argc = ac;
+        argv = av;
+        if (has_arg("-h", "--help")) {
+            print_help();
+            valid_state = false;
+            return;
+        }
+        // The input may be "-" for stdin.
+        if (argc < 3 || (argv[1][0] == '-' && std::string(argv[1]) != "-") || argv[2][0] == '-') {
+            print_usage();
+            valid_state = false;
+            return;
+        }
+        gfa1_filename = argv[1];
+        out_stem = argv[2];
+        set_value(n_threads, "-t", "--threads");
+        grouped_paths = has_arg("-g", "--grouped-paths");
+        presence_matrix = has_arg("-b", "--presence-matrix");
+        set_value(min_maf, "-m", "--min-maf");
+        drop_all_present = has_arg("-a", "--drop-all-present");
+        packed_paths = has_arg("-p", "--packed-paths");
+        binary_graph = has_arg("-B", "--binary-graph");
+        report = has_arg("-r", "--report");
+        set_value(reduced_gfa_k, "-R", "--reduced-gfa");
+        save_state = has_arg("-s", "--save-state");
+        set_value(previous_stem, "-i", "--incremental");
+        std::string max_memory_str;
+        set_value(max_memory_str, "-M", "--max-memory");
+        if (!max_memory_str.empty() && !MemoryBudget::parse(max_memory_str, max_memory)) max_memory = UINT64_MAX;
+
+        valid_state = all_required_arguments_provided();
+    }
+
+    // Output file paths.
+    static std::string edges_filename() { return out_stem + ".edges"; }
+    static std::string unitigs_filename() { return out_stem + ".unitigs"; }
+    static std::string lengths_filename() { return out_stem + ".lengths"; }
+    static std::string fasta_filename() { return out_stem + ".fasta"; }
+    static std::string counts_filename() { return out_stem + ".counts"; }
+    static std::string paths_filename() { return out_stem + ".paths"; }
+    static std::string presence_matrix_filename() { return out_stem + ".pam"; }
+    static std::string presence_matrix_index_filename() { return out_stem + ".pam_index"; }
+    static std::string binary_graph_filename() { return out_stem + ".graph"; }
+    static std::string packed_paths_filename() { return out_stem + ".sggs"; }
+    static std::string report_filename() { return out_stem + ".report.json"; }
+    static std::string state_filename() { return out_stem + ".state"; }
+    static std::string tmp_directory() { return out_stem + "_tmp"; }
+    static std::string path_directory() { return out_stem + "_paths"; }
+
+    // Input files of Cuttlefish's reduced GFA output, with gfa1_filename as their prefix.
+    static std::string cf_seg_filename() { return gfa1_filename + ".cf_seg"; }
+    static std::string cf_seq_filename() { return gfa1_filename + ".cf_seq"; }
+    static bool reduced_gfa() { return reduced_gfa_k != 0; }
+
+    // Files of the previous run with '-i'.
+    static bool incremental() { return !previous_stem.empty(); }
+    static std::string previous_state_filename() { return previous_stem + ".state"; }
+    static std::string previous_unitigs_filename() { return previous_stem + ".unitigs"; }
+    static std::string previous_fasta_filename() { return previous_stem + ".fasta"; }
+    static std::string previous_paths_filename() { return previous_stem + ".paths"; }
+    static std::string previous_packed_paths_filename() { return previous_stem + ".sggs"; }
+
+    static std::string gfa1_filename;
+    static std::string out_stem;
+    static int64_t n_threads;
+    static bool grouped_paths;
+    static bool presence_matrix;
+    static double min_maf;
+    static bool drop_all_present;
+    static bool packed_paths;
+    static bool binary_graph;
+    static bool report;
+    static int64_t reduced_gfa_k;
+    static bool save_state;
+    static std::string previous_stem;
+    static uint64_t max_memory;
+    static bool valid_state;
+
+    static uint64_t links_memory() { return MemoryBudget::links_memory(max_memory); }
+    static uint64_t path_lines_memory() { return MemoryBudget::path_lines_memory(max_memory); }
+    static uint64_t pipeline_memory() { return MemoryBudget::pipeline_memory(max_memory); }
+
+private:
+    static int argc;
+    static char** argv;
+
+    static bool all_required_arguments_provided() {
+        bool ok = true;
+        if (n_threads < 1) {
+            std::cerr << "Error: Number of threads must be positive.\n";
+            ok = false;
+        }
+        if (min_maf < 0.0 || min_maf > 0.5) {
+            std::cerr << "Error: Minor allele frequency cutoff must be between 0 and 0.5.\n";
+            ok = false;
+        }
+        if (reduced_gfa_k < 0) {
+            std::cerr << "Error: K-mer length must be positive.\n";
+            ok = false;
+        }
+        if (reduced_gfa() && gfa1_filename == "-") {
+            std::cerr << "Error: Reduced GFA input can't be read from stdin.\n";
+            ok = false;
+        }
+        if (max_memory == UINT64_MAX) {
+            std::cerr << "Error: Memory budget must be given as bytes or with a suffix K, M, G or T, e.g. 64G.\n";
+            ok = false;
+        } else if (max_memory > 0 && max_memory < MemoryBudget::MIN_MEMORY) {
+            std::cerr << "Error: Memory budget must be at least " << (MemoryBudget::MIN_MEMORY >> 20) << "M.\n";
+            ok = false;
+        }
+        if (incremental() && previous_stem == out_stem) {
+            std::cerr << "Error: The previous run's outputs can't be overwritten, the output name must differ from the one given with '-i'.\n";
+            ok = false;
+        }
+        if (!presence_matrix && (min_maf > 0.0 || drop_all_present)) {
+            std::cerr << "Error: Filtering options require '-b' or '--presence-matrix'.\n";
+            ok = false;
+        }
+        if (!ok) print_no_args();
+        return ok;
+    }
+
+    static char** begin() { return argv + 3; }
+    static char** end() { return argv + argc; }
+    static char** find(const std::string& opt) { return std::find(begin(), end(), opt); }
+    static bool has_arg(const std::string& opt, const std::string& alt) {
+        return std::find(argv + 1, end(), opt) != end() || std::find(argv + 1, end(), alt) != end();
+    }
+    static char* find_arg_value(const std::string& opt, const std::string& alt) {
+        auto it = find(opt);
+        if (it != end() && ++it != end()) return *it;
+        it = find(alt);
+        return it != end() && ++it != end() ? *it : nullptr;
+    }
+
+    static void print_usage() {
+        std::cout << "Usage: " << argv[0] << " [../../input.gfa1] [../../output] (options)" << std::endl;
+        print_no_args();
+    }
+
+    static void print_no_args() { std::cout << "Use '-h' or '--help' for a list of available options.\n"; }
+
+    static void print_help() {
+        std::vector<std::string> options{
+            "Usage:", "",
+            "  gfa1_parser [../../input.gfa1] [../../output] (options)", "",
+            "  Input may be gzip/bgzip-compressed, a pipe or \"-\" for stdin.", "",
+            "  With '-R', input is the prefix of Cuttlefish's reduced GFA output files [input].cf_seg and [input].cf_seq.", "",
+            "", "",
+            "Options:", "",
+            "  -t  [ --threads ] arg (=1)", "Number of threads.",
+            "  -g  [ --grouped-paths ]", "Path lines are grouped by reference: write each path as soon as it is complete.",
+            "  -b  [ --presence-matrix ]", "Also write a bit-packed presence/absence matrix and its column index.",
+            "  -m  [ --min-maf ] arg (=0)", "Drop matrix columns with a minor allele frequency below arg.",
+            "  -a  [ --drop-all-present ]", "Drop matrix columns of unitigs present in every genome reference.",
+            "  -p  [ --packed-paths ]", "Write the edges of all genome references to a single indexed container file.",
+            "  -B  [ --binary-graph ]", "Also write the edges and unitig lengths as a binary graph, and packed paths as binary.",
+            "  -r  [ --report ]", "Write a JSON report of the time, throughput, peak memory and container sizes of each phase.",
+            "  -R  [ --reduced-gfa ] arg", "Read Cuttlefish's reduced GFA output, built with k-mer length arg.",
+            "  -s  [ --save-state ]", "Also write the state needed to add genome references to this run later with '-i'.",
+            "  -i  [ --incremental ] arg", "Add the genome references of the input to the previous run with output name arg.",
+            "  -M  [ --max-memory ] arg", "Keep the memory use within about arg bytes (e.g. 64G, at least 8M), spilling to disk.",
+            "  -h  [ --help ]", "Print this list.",
+        };
+        for (std::size_t i = 0; i < options.size(); i += 2) std::printf("%-45s %s\n", options[i].data(), options[i + 1].data());
+    }
+
+    template <typename T>
+    static void set_value(T& value, const std::string& opt, const std::string& alt) {
+        char* arg_value = find_arg_value(opt, alt);
+        if (arg_value != nullptr) std::stringstream(arg_value) >> value;
+    }
+
+};
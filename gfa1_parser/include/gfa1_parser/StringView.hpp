@@ -0,0 +1,53 @@
+/*
+    Non-owning view into a character buffer, used to reference fields of GFA1 lines without copying them.
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+class StringView {
+public:
+    StringView() : m_data(nullptr), m_size(0) { }
+    StringView(const char* data, std::size_t size) : m_data(data), m_size(size) { }
+    StringView(const char* begin, const char* end) : m_data(begin), m_size(end - begin) { }
+    StringView(const std::string& str) : m_data(str.data()), m_size(str.size()) { }
+
+    const char* data() const { return m_data; }
+    std::size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    const char* begin() const { return m_data; }
+    const char* end() const { return m_data + m_size; }
+
+    char operator[](std::size_t idx) const { return m_data[idx]; }
+    char front() const { return m_data[0]; }
+    char back() const { return m_data[m_size - 1]; }
+
+    void remove_suffix(std::size_t n) { m_size -= n; }
+
+    StringView substr(std::size_t pos, std::size_t count = std::string::npos) const {
+        if (pos > m_size) pos = m_size;
+        if (count > m_size - pos) count = m_size - pos;
+        return StringView(m_data + pos, count);
+    }
+
+    std::size_t find(const StringView& str, std::size_t pos = 0) const {
+        if (str.size() > m_size) return std::string::npos;
+        for (std::size_t idx = pos; idx + str.size() <= m_size; ++idx) {
+            if (std::memcmp(m_data + idx, str.data(), str.size()) == 0) return idx;
+        }
+        return std::string::npos;
+    }
+
+    std::string to_string() const { return std::string(m_data, m_size); }
+
+    bool operator==(const StringView& other) const { return m_size == other.m_size && (m_size == 0 || std::memcmp(m_data, other.m_data, m_size) == 0); }
+    bool operator!=(const StringView& other) const { return !(*this == other); }
+
+private:
+    const char* m_data;
+    std::size_t m_size;
+
+};
@@ -5,10 +5,10 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <map>
 #include <sstream>
 #include <string>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -19,34 +19,45 @@
 #include <direct.h>
 #endif
 
-using edge_type_t = std::pair<char, char>;
+#include "StringView.hpp"
 
 namespace gfa1_parser {
 
-    std::vector<std::string> get_fields(const std::string& line, char delim = '\t') {
-        std::vector<std::string> fields;
-        std::stringstream ss(line);
-        for (std::string field; std::getline(ss, field, delim); ) fields.push_back(std::move(field));
-        return fields;
+    // Split line into at most max_fields fields, returns the number of fields stored.
+    std::size_t get_fields(const StringView& line, StringView* fields, std::size_t max_fields, char delim = '\t') {
+        std::size_t n_fields = 0;
+        const char* field_begin = line.begin();
+        const char* line_end = line.end();
+        while (n_fields < max_fields && field_begin != line_end) {
+            const char* field_end = static_cast<const char*>(std::memchr(field_begin, delim, line_end - field_begin));
+            if (field_end == nullptr) field_end = line_end;
+            fields[n_fields++] = StringView(field_begin, field_end);
+            field_begin = field_end == line_end ? line_end : field_end + 1;
+        }
+        return n_fields;
     }
 
-    template <typename T>
-    std::vector<uint64_t> map_to_vector(const T& map, std::size_t sz) {
-        std::vector<uint64_t> vector(sz);
-        for (const auto& x : map) {
-            uint64_t id, count;
-            std::tie(id, count) = x;
-            vector[id] = count;
+    // Split line into fields, reusing the memory of the fields vector.
+    void get_fields(const StringView& line, std::vector<StringView>& fields, char delim = '\t') {
+        fields.clear();
+        const char* field_begin = line.begin();
+        const char* line_end = line.end();
+        while (field_begin != line_end) {
+            const char* field_end = static_cast<const char*>(std::memchr(field_begin, delim, line_end - field_begin));
+            if (field_end == nullptr) field_end = line_end;
+            fields.emplace_back(field_begin, field_end);
+            field_begin = field_end == line_end ? line_end : field_end + 1;
         }
-        return vector;
     }
 
-    template <typename T>
-    std::vector<uint64_t> map_keys_to_vector(const T& map) {
-        std::vector<uint64_t> vector;
-        for (const auto& x : map) vector.push_back(x.first);
-        std::sort(vector.begin(), vector.end());
-        return vector;
+    // Parse the leading digits of a field such as "60M" like std::stoull would.
+    uint64_t to_uint64(const StringView& field) {
+        uint64_t value = 0;
+        for (char c : field) {
+            if (c < '0' || c > '9') break;
+            value = value * 10 + (c - '0');
+        }
+        return value;
     }
 
     template <typename T>
@@ -62,19 +73,6 @@ namespace gfa1_parser {
         }
     }
 
-    edge_type_t get_edge_type(char from_orient, char to_orient) {
-        static const std::vector<edge_type_t> conv = [] {
-            int plus = '+', minus = '-';
-            std::vector<edge_type_t> conv(3 * minus + 1);
-            conv[2 * plus + plus] = std::make_pair('F', 'F');
-            conv[2 * plus + minus] = std::make_pair('F', 'R');
-            conv[2 * minus + plus] = std::make_pair('R', 'F');
-            conv[2 * minus + minus] = std::make_pair('R', 'R');
-            return conv;
-        }();
-        return conv[2 * from_orient + to_orient];
-    }
-
     std::string neat_number_str(uint64_t number) {
         std::vector<uint64_t> parts;
         do parts.push_back(number % 1000);
@@ -91,6 +89,12 @@ namespace gfa1_parser {
         return stat(directory.c_str(), &info) == 0 && info.st_mode & S_IFDIR;
     }
 
+    // Returns 0 if the file doesn't exist.
+    uint64_t file_size(const std::string& filename) {
+        struct stat info;
+        return stat(filename.c_str(), &info) == 0 ? info.st_size : 0;
+    }
+
     int create_directory(const std::string& directory) {
         #ifdef WIN32
         return _mkdir(directory.c_str());
@@ -0,0 +1,21 @@
+#include "ProgramOptions.hpp"
+
+int ProgramOptions::argc;
+char** ProgramOptions::argv;
+
+std::string ProgramOptions::gfa1_filename = "";
+std::string ProgramOptions::out_stem = "";
+int64_t ProgramOptions::n_threads = 1;
+bool ProgramOptions::grouped_paths = false;
+bool ProgramOptions::presence_matrix = false;
+double ProgramOptions::min_maf = 0.0;
+bool ProgramOptions::drop_all_present = false;
+bool ProgramOptions::packed_paths = false;
+bool ProgramOptions::binary_graph = false;
+bool ProgramOptions::report = false;
+int64_t ProgramOptions::reduced_gfa_k = 0;
+bool ProgramOptions::save_state = false;
+std::string ProgramOptions::previous_stem = "";
+uint64_t ProgramOptions::max_memory = 0;
+
+bool ProgramOptions::valid_state = true;
@@ -1,81 +1,185 @@
+#include <cstdio>
 #include <fstream>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "BinaryGraphWriter.hpp"
+#include "Block.hpp"
+#include "BlockPipeline.hpp"
 #include "Errors.hpp"
-#include "LineReader.hpp"
+#include "InputBuffer.hpp"
 #include "Links.hpp"
+#include "MemoryBudget.hpp"
+#include "PackedPaths.hpp"
 #include "Parser.hpp"
+#include "ParserState.hpp"
 #include "Paths.hpp"
+#include "PhaseReport.hpp"
+#include "PresenceMatrix.hpp"
+#include "ProgramOptions.hpp"
 #include "Segments.hpp"
 
+static_assert(MemoryBudget::pipeline_memory(MemoryBudget::MIN_MEMORY) >= BlockPipeline::MIN_MEMORY, "The smallest memory budget is too small for the block pipeline.");
+
 int main(int argc, char** argv) {
-    if (argc < 3) {
-        std::cout << "Usage: " << argv[0] << " [../../input.gfa1] [../../output]" << std::endl;
-        return 1;
-    }
+    // Read command line arguments.
+    ProgramOptions::read_command_line_arguments(argc, argv);
+    if (!ProgramOptions::valid_state) return 1;
 
     auto time_program_start = gfa1_parser::time_now();
 
     std::cout << "gfa1_parser | MIT License | Copyright (c) 2021 Juri Kuronen\n\n";
 
-    // Read command line arguments.
-    const std::string gfa1_path(argv[1]);
-    const std::string output_stem(argv[2]);
+    const std::string& gfa1_path = ProgramOptions::gfa1_filename;
 
     // Output file paths.
-    const std::string edges_filename = output_stem + ".edges";
-    const std::string unitigs_filename = output_stem + ".unitigs";
-    const std::string fasta_filename = output_stem + ".fasta";
-    const std::string counts_filename = output_stem + ".counts";
-    const std::string paths_filename = output_stem + ".paths";
-    const std::string path_directory = output_stem + "_paths";
-
-    // Create the path directory if it doesn't exist.
-    if (!gfa1_parser::directory_exists(path_directory)) {
+    const std::string edges_filename = ProgramOptions::edges_filename();
+    const std::string unitigs_filename = ProgramOptions::unitigs_filename();
+    const std::string lengths_filename = ProgramOptions::lengths_filename();
+    const std::string fasta_filename = ProgramOptions::fasta_filename();
+    const std::string counts_filename = ProgramOptions::counts_filename();
+    const std::string paths_filename = ProgramOptions::paths_filename();
+    const std::string path_directory = ProgramOptions::path_directory();
+    const std::string packed_paths_filename = ProgramOptions::packed_paths_filename();
+    const std::string binary_graph_filename = ProgramOptions::binary_graph_filename();
+    const std::string presence_matrix_filename = ProgramOptions::presence_matrix_filename();
+    const std::string presence_matrix_index_filename = ProgramOptions::presence_matrix_index_filename();
+    const std::string report_filename = ProgramOptions::report_filename();
+    const std::string state_filename = ProgramOptions::state_filename();
+
+    // Create the path directory if it doesn't exist. Packed paths don't need it.
+    if (!ProgramOptions::packed_paths && !gfa1_parser::directory_exists(path_directory)) {
         if (gfa1_parser::create_directory(path_directory) != 0) {
             std::cerr << "Failed to create directory \"" << path_directory << "\"." << std::endl;
             return -1;
         }
     }
 
-    // Open stream to GFA1 file.
-    std::ifstream ifs(gfa1_path);
-    if (!ifs.good()) {
-        std::cerr << "Can't open \"" << gfa1_path << "\"." << std::endl;
-        return 1;
+    // Input files: the GFA1 file, or the segment file followed by the sequence tiling file of a reduced GFA.
+    std::vector<std::pair<std::string, InputFormat>> input_files;
+    if (ProgramOptions::reduced_gfa()) {
+        input_files.emplace_back(ProgramOptions::cf_seg_filename(), InputFormat::CUTTLEFISH_SEGMENTS);
+        input_files.emplace_back(ProgramOptions::cf_seq_filename(), InputFormat::CUTTLEFISH_TILINGS);
+    } else {
+        input_files.emplace_back(gfa1_path, InputFormat::GFA1);
     }
 
     // Initialization.
     Segments segments;
-    Links links(4ULL * 1024 * 1024);
+    if (!segments.open(unitigs_filename)) {
+        std::cerr << "Can't open \"" << unitigs_filename << "\"." << std::endl;
+        return 1;
+    }
+    Links links;
     Paths paths;
     PathData path_data;
 
+    // Within a memory budget, the links and the path lines are spilled to a temporary directory past their shares of it.
+    const std::string tmp_directory = ProgramOptions::tmp_directory();
+    if (ProgramOptions::max_memory > 0) {
+        if (!gfa1_parser::directory_exists(tmp_directory) && gfa1_parser::create_directory(tmp_directory) != 0) {
+            std::cerr << "Failed to create directory \"" << tmp_directory << "\"." << std::endl;
+            return 1;
+        }
+        links.set_spill(tmp_directory + "/links", ProgramOptions::links_memory());
+        if (!path_data.set_spill(tmp_directory + "/path_lines", ProgramOptions::path_lines_memory())) {
+            std::cerr << "Can't open \"" << tmp_directory << "/path_lines\"." << std::endl;
+            return 1;
+        }
+    }
+
+    PhaseReport report(segments, links, path_data);
+
     Errors errors;
-    LineReader line_reader(errors);
-    Parser parser(segments, links, paths, path_data, errors);
+    Parser parser(segments, links, paths, path_data, errors, ProgramOptions::n_threads, ProgramOptions::grouped_paths);
+    // Consecutive segments of the sequence tilings overlap by k - 1.
+    const uint64_t tiling_overlap = ProgramOptions::reduced_gfa() ? ProgramOptions::reduced_gfa_k - 1 : 0;
+    if (ProgramOptions::reduced_gfa()) parser.set_tilings(tiling_overlap);
+    // The paths being finished share the path lines' part of the memory budget, the lines of a path are read back only then.
+    if (ProgramOptions::max_memory > 0) parser.set_max_batch_memory(ProgramOptions::path_lines_memory());
+    PackedPaths packed_paths;
+    if (ProgramOptions::packed_paths) {
+        if (!packed_paths.open(packed_paths_filename)) {
+            std::cerr << "Can't open \"" << packed_paths_filename << "\"." << std::endl;
+            return 1;
+        }
+        parser.set_packed_paths(packed_paths, ProgramOptions::binary_graph);
+    }
+    if (!parser.open_path_files(fasta_filename, paths_filename, path_directory)) {
+        std::cerr << "Can't open \"" << fasta_filename << "\" or \"" << paths_filename << "\"." << std::endl;
+        return 1;
+    }
+    PresenceMatrix presence_matrix;
+    if (ProgramOptions::presence_matrix) {
+        if (!presence_matrix.open(presence_matrix_filename)) {
+            std::cerr << "Can't open \"" << presence_matrix_filename << ".tmp\"." << std::endl;
+            return 1;
+        }
+        parser.set_presence_matrix(presence_matrix);
+    }
 
-    // Main file reading loop.
+    // Continue the previous run: its segments keep their ids and its paths come first in the outputs.
+    ParserState state;
+    if (ProgramOptions::incremental()) {
+        const std::string previous_state_filename = ProgramOptions::previous_state_filename();
+        const std::string previous_unitigs_filename = ProgramOptions::previous_unitigs_filename();
+        std::cout << "Reading " << previous_state_filename << " and " << previous_unitigs_filename << '.' << std::endl;
+        report.begin_phase("read_previous_run");
+        if (!state.read(previous_state_filename, previous_unitigs_filename, segments, links, paths)) {
+            std::cerr << "Failed to read the previous run from \"" << previous_state_filename << "\" and \"" << previous_unitigs_filename << "\"." << std::endl;
+            return 1;
+        }
+        parser.set_previous_run(state.references(), state.n_segments(), ProgramOptions::previous_fasta_filename(),
+                                ProgramOptions::previous_paths_filename(), ProgramOptions::previous_packed_paths_filename());
+        report.end_phase(state.n_segments(), gfa1_parser::file_size(previous_state_filename) + gfa1_parser::file_size(previous_unitigs_filename));
+    }
+
+    // Main file reading loop. Blocks are read and parsed by the pipeline's threads while the previous block is being processed here.
     bool ok = true;
-    const std::size_t block_size = 1000ULL * 1000 * 10;
+    const std::size_t pipeline_memory = ProgramOptions::pipeline_memory();
 
     auto time_main_loop_start = gfa1_parser::time_now();
     std::cout << "Reading GFA1 lines..." << std::flush;
-    for (std::size_t idx = 0; ok && ifs.peek() != EOF; ) {
-        ok = line_reader.read_next_block(ifs, idx, idx + block_size);
-        if (ok) ok = parser.process_segment_line_data(line_reader.segment_line_data());
-        if (ok) ok = parser.process_link_line_data(line_reader.link_line_data());
-        if (ok) ok = parser.process_path_line_data(line_reader.path_line_data());
-        line_reader.clear();
-        std::cout << "\rRead " << gfa1_parser::neat_number_str(idx) << " GFA1 lines. Stored "
+    std::size_t n_lines_read = 0;
+    uint64_t n_bytes_read = 0;
+    auto print_progress = [&]() {
+        std::cout << "\rRead " << gfa1_parser::neat_number_str(n_lines_read) << " GFA1 lines. Stored "
                   << gfa1_parser::neat_number_str(segments.size()) << " segments, "
                   << gfa1_parser::neat_number_str(links.n_links()) << " links and "
                   << gfa1_parser::neat_number_str(path_data.n_path_lines()) << " path lines." 
                   << " Time elapsed: " << gfa1_parser::time_elapsed(time_main_loop_start) << '.' << std::flush;
+    };
+    report.begin_phase("read_and_parse");
+    for (std::size_t file_idx = 0; ok && file_idx < input_files.size(); ++file_idx) {
+        const std::string& input_filename = input_files[file_idx].first;
+        InputBuffer input(BlockPipeline::input_memory(pipeline_memory));
+        if (!input.open(input_filename)) {
+            std::cerr << "\nCan't open \"" << input_filename << "\"." << std::endl;
+            return 1;
+        }
+        std::size_t n_lines_before = n_lines_read;
+        BlockPipeline pipeline(input, errors, ProgramOptions::n_threads, pipeline_memory, input_files[file_idx].second, tiling_overlap);
+        pipeline.start();
+        for (Block block; ok && pipeline.next_block(block); ) {
+            ok = block.ok();
+            if (ok) ok = parser.process_block(block);
+            input.release(block.end());
+            n_lines_read = n_lines_before + block.n_lines_read();
+            for (const auto& line_data : block.lines()) n_bytes_read += line_data.line().size() + 1;
+            print_progress();
+        }
+        pipeline.stop();
+        if (!ok && input_files.size() > 1) std::cerr << "\nFailed to parse \"" << input_filename << "\"." << std::endl;
+    }
+    // Deduplicate the remaining links for the final count.
+    if (ok && !links.compact()) {
+        errors.report("Failed to spill the links to \"" + tmp_directory + "\"");
+        ok = false;
     }
+    print_progress();
     std::cout << std::endl;
+    report.end_phase(n_lines_read, n_bytes_read);
 
     if (!ok) {
         errors.print_errors();
@@ -83,32 +187,118 @@ int main(int argc, char** argv) {
     }
 
     // Verify that a segment line existed for every segment name given in link lines.
+    report.begin_phase("validate_segments");
     for (std::size_t idx = 0; idx < segments.size(); ++idx) {
-        if (segments[idx].empty()) {
+        if (!segments.has_sequence(idx)) {
             std::cerr << "Segment line missing for segment with name " << segments.idx_to_gfa1_name(idx) << "." << std::endl;
             return 1;
         }
     }
+    report.end_phase(0, 0);
 
     std::cout << "Writing " << edges_filename << '.' << std::endl;
-    links.write_out(edges_filename);
+    report.begin_phase("write_edges");
+    if (!links.write_out(edges_filename)) {
+        std::cerr << "Failed to write \"" << edges_filename << "\"." << std::endl;
+        return 1;
+    }
+    report.end_phase(links.n_links(), gfa1_parser::file_size(edges_filename));
 
     std::cout << "Writing " << unitigs_filename << '.' << std::endl;
-    segments.write_out(unitigs_filename);
+    report.begin_phase("write_unitigs");
+    if (!segments.write_out()) {
+        std::cerr << "Failed to write \"" << unitigs_filename << "\"." << std::endl;
+        return 1;
+    }
+    report.end_phase(segments.size(), gfa1_parser::file_size(unitigs_filename));
 
-    paths.set_n_segments(segments.size());
+    std::cout << "Writing " << lengths_filename << '.' << std::endl;
+    report.begin_phase("write_lengths");
+    if (!segments.write_lengths(lengths_filename)) {
+        std::cerr << "Failed to write \"" << lengths_filename << "\"." << std::endl;
+        return 1;
+    }
+    report.end_phase(segments.size(), gfa1_parser::file_size(lengths_filename));
+
+    if (ProgramOptions::binary_graph) {
+        std::cout << "Writing " << binary_graph_filename << '.' << std::endl;
+        report.begin_phase("write_binary_graph");
+        {
+            std::ofstream ofs(binary_graph_filename, std::ios::binary);
+            BinaryGraphWriter binary_graph(ofs);
+            segments.write_lengths(binary_graph);
+            bool links_ok = links.write_out(binary_graph);
+            if (!binary_graph.finish() || !links_ok) {
+                std::cerr << "Failed to write \"" << binary_graph_filename << "\"." << std::endl;
+                return 1;
+            }
+        }
+        report.end_phase(0, gfa1_parser::file_size(binary_graph_filename));
+    }
 
     std::cout << "Processing paths..." << std::flush;
-    if (!parser.process_paths(fasta_filename, paths_filename, path_directory)) {
+    report.begin_phase("process_paths");
+    uint64_t n_path_lines = path_data.n_path_lines();
+    if (!parser.process_paths()) {
         errors.print_errors();
         return 1;
     }
+    if (!parser.close_path_files()) {
+        std::cerr << "Failed to write \"" << fasta_filename << "\" or \"" << paths_filename << "\"." << std::endl;
+        return 1;
+    }
     std::cout << "Wrote " << fasta_filename << '.' << std::endl;
-    std::cout << "Wrote " << paths_filename << '.' << std::endl;
-    std::cout << "Wrote paths to " << path_directory << "/." << std::endl;
+    if (ProgramOptions::packed_paths) {
+        if (!packed_paths.write_out()) {
+            std::cerr << "Failed to write \"" << packed_paths_filename << "\"." << std::endl;
+            return 1;
+        }
+        std::cout << "Wrote " << packed_paths_filename << '.' << std::endl;
+    } else {
+        std::cout << "Wrote " << paths_filename << '.' << std::endl;
+        std::cout << "Wrote paths to " << path_directory << "/." << std::endl;
+    }
+    // Path lines processed here, and the fasta file and packed paths written for all paths.
+    report.end_phase(n_path_lines, gfa1_parser::file_size(fasta_filename) + (ProgramOptions::packed_paths ? gfa1_parser::file_size(packed_paths_filename) : 0));
 
     std::cout << "Writing " << counts_filename << '.' << std::endl;
-    paths.write_counts(counts_filename);
+    report.begin_phase("write_counts");
+    uint64_t n_count_lines = paths.write_counts(counts_filename);
+    report.end_phase(n_count_lines, gfa1_parser::file_size(counts_filename));
+
+    if (ProgramOptions::presence_matrix) {
+        std::cout << "Writing " << presence_matrix_filename << " and " << presence_matrix_index_filename << '.' << std::endl;
+        report.begin_phase("write_presence_matrix");
+        if (!presence_matrix.write_out(presence_matrix_filename, presence_matrix_index_filename, ProgramOptions::min_maf, ProgramOptions::drop_all_present)) {
+            std::cerr << "Failed to write \"" << presence_matrix_filename << "\"." << std::endl;
+            return 1;
+        }
+        report.end_phase(0, gfa1_parser::file_size(presence_matrix_filename) + gfa1_parser::file_size(presence_matrix_index_filename));
+    }
+
+    if (ProgramOptions::save_state) {
+        std::cout << "Writing " << state_filename << '.' << std::endl;
+        report.begin_phase("write_state");
+        if (!state.write_out(state_filename, segments, links, paths)) {
+            std::cerr << "Failed to write \"" << state_filename << "\"." << std::endl;
+            return 1;
+        }
+        report.end_phase(0, gfa1_parser::file_size(state_filename));
+    }
+
+    if (ProgramOptions::report) {
+        std::cout << "Writing " << report_filename << '.' << std::endl;
+        if (!report.write_out(report_filename, gfa1_path, ProgramOptions::n_threads)) {
+            std::cerr << "Failed to write \"" << report_filename << "\"." << std::endl;
+            return 1;
+        }
+    }
+
+    if (ProgramOptions::max_memory > 0) {
+        links.clear();
+        path_data.remove_spill();
+        std::remove(tmp_directory.c_str());
+    }
 
     std::cout << "gfa1_parser finished in " << gfa1_parser::time_elapsed(time_program_start) << '.' << std::endl;
 
@@ -0,0 +1,109 @@
+/*
+    Reader for the binary graph format written by gfa1_parser with '-B'.
+    Files are memory-mapped and the words are read in place, so loading doesn't need any parsing.
+
+    Binary graph layout (all integers are 64-bit little-endian words):
+        magic "GFA1BIN\0", version, n_lengths, n_edges, checksum,
+        n_lengths unitig lengths in id order,
+        n_edges edge records of from_id, to_id and overlap << 2 | edge type (FF, FR, RF and RR are 0, 1, 2 and 3).
+    The checksum is a word-wise FNV-1a hash of the words following the header. Ids are zero-based.
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class BinaryGraph {
+public:
+    static constexpr uint64_t VERSION = 1;
+
+    BinaryGraph() : m_data(nullptr), m_size(0), m_mapped(false), m_n_lengths(0), m_n_edges(0) { }
+    ~BinaryGraph() { if (m_mapped) munmap(const_cast<unsigned char*>(m_data), m_size); }
+    BinaryGraph(const BinaryGraph& other) = delete;
+    BinaryGraph& operator=(const BinaryGraph& other) = delete;
+
+    // Check the magic to tell a binary graph from a text file.
+    static bool is_binary(const char* data, std::size_t size) { return size >= MAGIC_SIZE && std::memcmp(data, MAGIC, MAGIC_SIZE) == 0; }
+    static bool is_binary(const std::string& filename) {
+        char magic[MAGIC_SIZE];
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        bool binary = ::read(fd, magic, MAGIC_SIZE) == (ssize_t) MAGIC_SIZE && is_binary(magic, MAGIC_SIZE);
+        ::close(fd);
+        return binary;
+    }
+
+    // Memory-map a binary graph file and validate it.
+    bool open(const std::string& filename) {
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        void* data = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED) return false;
+        m_mapped = true;
+        madvise(data, st.st_size, MADV_SEQUENTIAL);
+        return view(static_cast<const char*>(data), st.st_size);
+    }
+
+    // Use a binary graph held in memory, e.g. a block of a packed single genome graphs file. The data must outlive this object.
+    bool view(const char* data, std::size_t size) {
+        m_data = reinterpret_cast<const unsigned char*>(data);
+        m_size = size;
+        if (!is_binary(data, size) || size < HEADER_SIZE || word(1) != VERSION) return false;
+        m_n_lengths = word(2);
+        m_n_edges = word(3);
+        uint64_t n_words = (size - HEADER_SIZE) / 8;
+        if (size % 8 != 0 || m_n_edges > n_words / 3 || m_n_lengths != n_words - 3 * m_n_edges) return false;
+        return checksum() == word(4);
+    }
+
+    uint64_t n_lengths() const { return m_n_lengths; }
+    uint64_t n_edges() const { return m_n_edges; }
+
+    uint64_t length(std::size_t idx) const { return word(HEADER_WORDS + idx); }
+
+    uint64_t edge_from(std::size_t idx) const { return word(edge_word(idx)); }
+    uint64_t edge_to(std::size_t idx) const { return word(edge_word(idx) + 1); }
+    uint64_t edge_overlap(std::size_t idx) const { return word(edge_word(idx) + 2) >> 2; }
+    // The from side is F in edge types FF and FR, the to side is R in edge types FR and RR.
+    bool edge_from_forward(std::size_t idx) const { return (word(edge_word(idx) + 2) & 2) == 0; }
+    bool edge_to_reverse(std::size_t idx) const { return (word(edge_word(idx) + 2) & 1) != 0; }
+
+private:
+    static constexpr const char* MAGIC = "GFA1BIN"; // The string literal includes the terminating '\0'.
+    static constexpr std::size_t MAGIC_SIZE = 8;
+    static constexpr std::size_t HEADER_WORDS = 5;
+    static constexpr std::size_t HEADER_SIZE = 8 * HEADER_WORDS;
+    static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+    static constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+    const unsigned char* m_data;
+    std::size_t m_size;
+    bool m_mapped;
+    uint64_t m_n_lengths;
+    uint64_t m_n_edges;
+
+    std::size_t edge_word(std::size_t idx) const { return HEADER_WORDS + m_n_lengths + 3 * idx; }
+
+    // Compiles to a plain load on little-endian hosts.
+    uint64_t word(std::size_t idx) const {
+        const unsigned char* bytes = m_data + 8 * idx;
+        uint64_t value = 0;
+        for (int i = 7; i >= 0; --i) value = value << 8 | bytes[i];
+        return value;
+    }
+
+    uint64_t checksum() const {
+        uint64_t h = FNV_OFFSET_BASIS;
+        for (std::size_t idx = HEADER_WORDS; idx < m_size / 8; ++idx) h = (h ^ word(idx)) * FNV_PRIME;
+        return h;
+    }
+
+};
@@ -0,0 +1,487 @@
+/*
+    Contraction hierarchy of a graph with integer weights, for exact distance queries that explore only a small part of the graph.
+    Nodes are contracted in rounds, each of which contracts in parallel the nodes whose priority is a local minimum. Contracting a node
+    adds a shortcut between two of its neighbors unless a bounded witness search finds a path between them that isn't longer, and the
+    node keeps its edges to the neighbors contracted after it. Every shortest distance is then the length of a path that goes only up these edges from both ends.
+    A query searches upward from the sources and from each target, or for many targets sweeps down over all nodes (PHAST).
+    Nodes are stored in rank order, so the sweep reads the arrays sequentially.
+
+    Contraction hierarchy file layout (all integers are 64-bit little-endian words):
+        magic "UDCHIDX\0", version, n_nodes, n_edges, graph checksum, checksum,
+        n_nodes ranks in node id order,
+        n_nodes + 1 upward edge offsets in rank order,
+        n_edges upward edge records of head rank and weight.
+    The graph checksum is a word-wise FNV-1a hash of the graph's adjacency arrays, so that a file is only used for the graph it was
+    built for. The checksum is the same hash of the words following the header.
+*/
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "Graph.hpp"
+#include "PrintUtils.hpp"
+#include "ProgramOptions.hpp"
+#include "SearchWorkspace.hpp"
+#include "Timer.hpp"
+#include "types.hpp"
+#include "Utils.hpp"
+
+class ContractionHierarchy {
+public:
+    static constexpr uint64_t VERSION = 1;
+
+    ContractionHierarchy() = default;
+    ContractionHierarchy(const ContractionHierarchy& other) = delete;
+    ContractionHierarchy& operator=(const ContractionHierarchy& other) = delete;
+
+    // Number of nodes, zero if the hierarchy wasn't built or loaded.
+    std::size_t size() const { return m_ranks.size(); }
+
+    std::size_t n_edges() const { return m_heads.size(); }
+
+    // Contract the graph, printing the progress under -v. Returns false if the graph has real weights.
+    bool build(const Graph& graph, const Timer& timer, int_t n_threads = 1) {
+        if (!graph.integer_weights()) {
+            std::cerr << "Error: Contraction hierarchies need integer edge weights." << std::endl;
+            return false;
+        }
+        std::size_t n_nodes = graph.size();
+        Adjacency adjacency(n_nodes);
+        for (std::size_t v = 0; v < n_nodes; ++v) {
+            graph.for_each_neighbor(v, [&adjacency, v](int_t w, real_t weight) { adjacency[v].emplace_back(w, weight); });
+        }
+
+        // Priorities depend on the contracted neighbors and their levels in the hierarchy. They are estimated with hop-limited
+        // witness searches, which are much cheaper than the searches for the shortcuts that are added.
+        std::vector<int_t> n_contracted_neighbors(n_nodes, 0), levels(n_nodes, 0), priorities(n_nodes);
+        std::vector<bool> contracting(n_nodes, false);
+        std::vector<SearchWorkspace> workspaces(n_threads);
+        std::vector<std::vector<Shortcut>> thread_shortcuts(n_threads);
+        auto update_priority = [&](std::size_t thr, index_t v) {
+            auto& shortcuts = thread_shortcuts[thr];
+            find_shortcuts(adjacency, contracting, v, PRIORITY_SETTLE_LIMIT, PRIORITY_HOP_LIMIT, workspaces[thr], shortcuts);
+            priorities[v] = (int_t) shortcuts.size() - (int_t) adjacency[v].size() + n_contracted_neighbors[v] + levels[v];
+        };
+        for_each_in_threads(n_threads, n_nodes, update_priority);
+
+        // Contract in rounds the nodes whose priorities are smaller than those of their remaining neighbors, ties broken by id.
+        // No two of them are neighbors and their witness searches avoid all of them, so they can be contracted independently.
+        // Only the neighbors of the contracted nodes need new priorities.
+        std::vector<index_t> ranks(n_nodes);
+        std::vector<index_t> selected, touched;
+        std::vector<bool> is_touched(n_nodes, false);
+        std::vector<std::vector<Shortcut>> shortcuts;
+        std::vector<index_t> remaining(n_nodes);
+        for (std::size_t v = 0; v < n_nodes; ++v) remaining[v] = v;
+        index_t rank = 0;
+        std::size_t n_remaining_printed = n_nodes;
+        while (!remaining.empty()) {
+            selected.clear();
+            for (auto v : remaining) {
+                bool local_minimum = std::all_of(adjacency[v].begin(), adjacency[v].end(), [&priorities, v](const AdjacencyEdge& e) {
+                    return priorities[v] < priorities[e.first] || (priorities[v] == priorities[e.first] && v < e.first);
+                });
+                if (local_minimum) selected.push_back(v);
+            }
+            for (auto v : selected) contracting[v] = true;
+            shortcuts.resize(selected.size());
+            for_each_in_threads(n_threads, selected.size(), [&](std::size_t thr, std::size_t idx) {
+                find_shortcuts(adjacency, contracting, selected[idx], WITNESS_SETTLE_LIMIT, WITNESS_HOP_LIMIT, workspaces[thr], shortcuts[idx]);
+            });
+
+            touched.clear();
+            for (std::size_t idx = 0; idx < selected.size(); ++idx) {
+                index_t v = selected[idx];
+                ranks[v] = rank++;
+                for (const auto& edge : adjacency[v]) {
+                    auto& neighbors = adjacency[edge.first];
+                    auto it = std::find_if(neighbors.begin(), neighbors.end(), [v](const AdjacencyEdge& e) { return e.first == v; });
+                    *it = neighbors.back();
+                    neighbors.pop_back();
+                    ++n_contracted_neighbors[edge.first];
+                    levels[edge.first] = std::max(levels[edge.first], levels[v] + 1);
+                    if (!is_touched[edge.first]) touched.push_back(edge.first);
+                    is_touched[edge.first] = true;
+                }
+                for (const auto& shortcut : shortcuts[idx]) {
+                    add_edge(adjacency[shortcut.u], shortcut.w, shortcut.weight);
+                    add_edge(adjacency[shortcut.w], shortcut.u, shortcut.weight);
+                }
+            }
+            remaining.erase(std::remove_if(remaining.begin(), remaining.end(), [&contracting](index_t v) { return contracting[v]; }), remaining.end());
+            for (auto v : touched) is_touched[v] = false;
+            for_each_in_threads(n_threads, touched.size(), [&](std::size_t thr, std::size_t idx) { update_priority(thr, touched[idx]); });
+
+            // The last nodes take the longest to contract, so the progress is printed whenever the remaining nodes have halved, down
+            // to the last percent of them.
+            if (ProgramOptions::verbose && remaining.size() <= n_remaining_printed / 2 && remaining.size() >= n_nodes / 100) {
+                PrintUtils::print_tbss_tsm(timer, "Contracted", Utils::neat_number_str(rank), '/', Utils::neat_number_str(n_nodes), "nodes");
+                n_remaining_printed = remaining.size();
+            }
+        }
+
+        // The remaining edges of each node lead to the nodes contracted after it.
+        std::size_t n_up_edges = 0;
+        for (const auto& edges : adjacency) n_up_edges += edges.size();
+        if (n_up_edges >= INDEX_T_MAX) {
+            std::cerr << "Error: Contraction hierarchy with " << n_up_edges << " edges is too large, build with 'make LARGE_GRAPHS=1'." << std::endl;
+            return false;
+        }
+        m_ranks = std::move(ranks);
+        m_offsets.assign(n_nodes + 1, 0);
+        for (std::size_t v = 0; v < n_nodes; ++v) m_offsets[m_ranks[v] + 1] = adjacency[v].size();
+        for (std::size_t r = 0; r < n_nodes; ++r) m_offsets[r + 1] += m_offsets[r];
+        m_heads.resize(m_offsets.back());
+        m_weights.resize(m_offsets.back());
+        for (std::size_t v = 0; v < n_nodes; ++v) {
+            index_t idx = m_offsets[m_ranks[v]];
+            for (const auto& edge : adjacency[v]) {
+                m_heads[idx] = m_ranks[edge.first];
+                m_weights[idx++] = edge.second;
+            }
+            Utils::clear(adjacency[v]);
+        }
+        return true;
+    }
+
+    // Read a hierarchy of the graph. Returns false with the reason in error if the file can't be read, is invalid or was built for
+    // another graph.
+    bool load(const std::string& filename, const Graph& graph, std::string& error) {
+        std::ifstream ifs(filename, std::ios::binary);
+        if (!ifs) {
+            error = "can't open the file";
+            return false;
+        }
+        char magic[MAGIC_SIZE];
+        if (!ifs.read(magic, MAGIC_SIZE) || std::memcmp(magic, MAGIC, MAGIC_SIZE) != 0) {
+            error = "not a contraction hierarchy file";
+            return false;
+        }
+        uint64_t version = read_word(ifs);
+        uint64_t n_nodes = read_word(ifs);
+        uint64_t n_up_edges = read_word(ifs);
+        uint64_t file_graph_checksum = read_word(ifs);
+        uint64_t checksum = read_word(ifs);
+        if (!ifs) {
+            error = "the file is truncated";
+            return false;
+        }
+        if (version != VERSION) {
+            error = "file version " + std::to_string(version) + ", expected " + std::to_string(VERSION);
+            return false;
+        }
+        if (n_nodes != graph.size() || file_graph_checksum != graph_checksum(graph)) {
+            error = "the file was built for another graph";
+            return false;
+        }
+        if (n_up_edges >= INDEX_T_MAX) {
+            error = "too many edges";
+            return false;
+        }
+
+        uint64_t h = FNV_OFFSET_BASIS;
+        auto next_word = [&ifs, &h]() {
+            uint64_t word = read_word(ifs);
+            h = (h ^ word) * FNV_PRIME;
+            return word;
+        };
+        m_ranks.resize(n_nodes);
+        for (auto& rank : m_ranks) rank = next_word();
+        m_offsets.resize(n_nodes + 1);
+        for (auto& offset : m_offsets) offset = next_word();
+        m_heads.resize(n_up_edges);
+        m_weights.resize(n_up_edges);
+        for (uint64_t idx = 0; idx < n_up_edges; ++idx) {
+            m_heads[idx] = next_word();
+            m_weights[idx] = next_word();
+        }
+        if (!ifs || h != checksum || !valid()) {
+            error = !ifs ? "the file is truncated" : h != checksum ? "checksum mismatch, the file is corrupted" : "invalid hierarchy";
+            clear();
+            return false;
+        }
+        return true;
+    }
+
+    bool save(const std::string& filename, const Graph& graph) const {
+        uint64_t h = FNV_OFFSET_BASIS;
+        for_each_word([&h](uint64_t word) { h = (h ^ word) * FNV_PRIME; });
+
+        std::ofstream ofs(filename, std::ios::binary);
+        ofs.write(MAGIC, MAGIC_SIZE);
+        write_word(ofs, VERSION);
+        write_word(ofs, size());
+        write_word(ofs, n_edges());
+        write_word(ofs, graph_checksum(graph));
+        write_word(ofs, h);
+        for_each_word([&ofs](uint64_t word) { write_word(ofs, word); });
+        ofs.close();
+        return !ofs.fail();
+    }
+
+    // Compute shortest distances between the sources and the targets in the workspace like Graph::distance().
+    // The sources must be at integer distances.
+    void distance(SearchWorkspace& workspace, real_t max_distance = REAL_T_MAX) const {
+        auto& forward = workspace.m_forward;
+        auto& backward = workspace.m_backward;
+        forward.reserve(size());
+        backward.reserve(size());
+
+        for (auto s : workspace.sources()) {
+            index_t r = m_ranks[s.first];
+            if (s.second >= forward.dist[r]) continue;
+            forward.set_distance(r, s.second);
+            forward.radix_heap.push((uint64_t) s.second, r);
+        }
+        upward_search(forward, max_distance);
+
+        auto& target_dist = workspace.m_target_dist;
+        target_dist.clear();
+        if (workspace.targets().size() * PHAST_NODES_PER_TARGET >= size()) {
+            real_t* dist = forward.dist.data();
+            downward_sweep(dist, max_distance);
+            for (auto target : workspace.targets()) target_dist.push_back(std::min(dist[m_ranks[target]], max_distance));
+            std::fill(forward.dist.begin(), forward.dist.end(), REAL_T_MAX); // The sweep doesn't record the nodes it touches.
+            forward.touched.clear();
+        } else {
+            for (auto target : workspace.targets()) target_dist.push_back(target_distance(forward.dist.data(), backward, m_ranks[target], max_distance));
+        }
+        forward.reset();
+    }
+
+private:
+    using AdjacencyEdge = std::pair<index_t, real_t>;
+    using Adjacency = std::vector<std::vector<AdjacencyEdge>>;
+
+    struct Shortcut {
+        index_t u;
+        index_t w;
+        real_t weight;
+    };
+
+    // Witness searches stop after settling this many nodes or at paths of this many edges and add the shortcuts they couldn't rule
+    // out. Estimating the priorities with shorter searches only overestimates the shortcuts of some nodes. The hop counts are bytes,
+    // so the searches for the shortcuts are limited only by the number of settled nodes.
+    static const std::size_t WITNESS_SETTLE_LIMIT = 1000;
+    static const std::size_t WITNESS_HOP_LIMIT = 255;
+    static const std::size_t PRIORITY_SETTLE_LIMIT = 100;
+    static const std::size_t PRIORITY_HOP_LIMIT = 3;
+
+    // Queries with more targets than one per this many nodes sweep the whole graph instead of searching from each target.
+    static const std::size_t PHAST_NODES_PER_TARGET = 1024;
+
+    static constexpr const char* MAGIC = "UDCHIDX"; // The string literal includes the terminating '\0'.
+    static constexpr std::size_t MAGIC_SIZE = 8;
+    static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+    static constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+    // Rank of each node, in node id order.
+    std::vector<index_t> m_ranks;
+
+    // The upward edges of the node of rank r are m_heads[m_offsets[r]], ..., m_heads[m_offsets[r + 1] - 1] with the weights at the
+    // same indices. Heads are ranks too.
+    std::vector<index_t> m_offsets;
+    std::vector<index_t> m_heads;
+    std::vector<real_t> m_weights;
+
+    void clear() {
+        Utils::clear(m_ranks);
+        Utils::clear(m_offsets);
+        Utils::clear(m_heads);
+        Utils::clear(m_weights);
+    }
+
+    // Check that the arrays read from a file describe a hierarchy, so that the searches stay within them.
+    bool valid() const {
+        if (m_offsets.front() != 0 || m_offsets.back() != m_heads.size()) return false;
+        for (std::size_t r = 0; r < size(); ++r) {
+            if (m_ranks[r] >= size() || m_offsets[r] > m_offsets[r + 1]) return false;
+            for (index_t idx = m_offsets[r]; idx < m_offsets[r + 1]; ++idx) {
+                if (m_heads[idx] <= r || m_heads[idx] >= size()) return false;
+            }
+        }
+        return true;
+    }
+
+    // Find the shortcuts needed to contract v: pairs of its neighbors that have no path as short as the one through v. The paths
+    // avoid the nodes that are being contracted and have at most hop_limit edges.
+    static void find_shortcuts(const Adjacency& adjacency, const std::vector<bool>& contracting, index_t v, std::size_t settle_limit,
+                               std::size_t hop_limit, SearchWorkspace& workspace, std::vector<Shortcut>& shortcuts) {
+        shortcuts.clear();
+        // Searching from the neighbors with the heaviest edges first keeps the searches from the other neighbors short.
+        auto& neighbors = workspace.m_sources;
+        neighbors.assign(adjacency[v].begin(), adjacency[v].end());
+        std::sort(neighbors.begin(), neighbors.end(), [](const std::pair<int_t, real_t>& a, const std::pair<int_t, real_t>& b) {
+            return a.second > b.second;
+        });
+        workspace.reserve(adjacency.size());
+        auto& state = workspace.m_forward;
+        auto& is_target = workspace.m_is_target;
+        auto& hops = workspace.m_hops;
+        if (hops.size() < adjacency.size()) hops.resize(adjacency.size());
+        real_t* dist = state.dist.data();
+        auto& queue = state.radix_heap;
+        for (std::size_t i = 0; i + 1 < neighbors.size(); ++i) {
+            index_t u = neighbors[i].first;
+            for (std::size_t j = i + 1; j < neighbors.size(); ++j) is_target[neighbors[j].first] = true;
+
+            // Search from u for paths that avoid v and aren't longer than the paths through v, until the other neighbors are settled.
+            // The targets are in decreasing order of weight, so the search ends at the path through v to the first unsettled one.
+            std::size_t first_target = i + 1;
+            state.set_distance(u, 0.0);
+            hops[u] = 0;
+            queue.push(0, u);
+            std::size_t n_settled = 0;
+            while (!queue.empty()) {
+                uint64_t distance;
+                int_t x;
+                std::tie(distance, x) = queue.pop();
+                if (distance > dist[x]) continue; // Stale entry.
+                is_target[x] = false;
+                while (first_target < neighbors.size() && !is_target[neighbors[first_target].first]) ++first_target;
+                if (first_target == neighbors.size()) break;
+                real_t max_distance = neighbors[i].second + neighbors[first_target].second;
+                if (distance > max_distance || ++n_settled > settle_limit) break;
+                if (hops[x] == hop_limit) continue;
+                for (const auto& edge : adjacency[x]) {
+                    real_t y_distance = distance + edge.second;
+                    if (edge.first != v && !contracting[edge.first] && y_distance <= max_distance && y_distance < dist[edge.first]) {
+                        state.set_distance(edge.first, y_distance);
+                        hops[edge.first] = hops[x] + 1;
+                        queue.push((uint64_t) y_distance, edge.first);
+                    }
+                }
+            }
+            for (std::size_t j = i + 1; j < neighbors.size(); ++j) {
+                real_t weight = neighbors[i].second + neighbors[j].second;
+                if (dist[neighbors[j].first] > weight) shortcuts.push_back(Shortcut{u, (index_t) neighbors[j].first, weight});
+                is_target[neighbors[j].first] = false;
+            }
+            state.reset();
+        }
+    }
+
+    // Call f(thread, idx) for each idx below n, spread over the threads.
+    template <typename F>
+    static void for_each_in_threads(int_t n_threads, std::size_t n, F f) {
+        std::vector<std::thread> threads;
+        for (int_t thr = 0; thr < n_threads; ++thr) {
+            threads.emplace_back([&f, n, n_threads, thr]() { for (std::size_t idx = thr; idx < n; idx += n_threads) f(thr, idx); });
+        }
+        for (auto& thr : threads) thr.join();
+    }
+
+    // Add an edge to a node's remaining edges, or decrease the weight of an existing one.
+    static void add_edge(std::vector<AdjacencyEdge>& edges, index_t w, real_t weight) {
+        auto it = std::find_if(edges.begin(), edges.end(), [w](const AdjacencyEdge& e) { return e.first == w; });
+        if (it == edges.end()) edges.emplace_back(w, weight);
+        else it->second = std::min(it->second, weight);
+    }
+
+    // Dijkstra's algorithm on the upward edges from the nodes in the queue, up to max_distance.
+    void upward_search(SearchWorkspace::SearchState& state, real_t max_distance) const {
+        real_t* dist = state.dist.data();
+        auto& queue = state.radix_heap;
+        while (!queue.empty()) {
+            uint64_t distance;
+            int_t r;
+            std::tie(distance, r) = queue.pop();
+            if (distance > dist[r]) continue; // Stale entry.
+            for (index_t idx = m_offsets[r]; idx < m_offsets[r + 1]; ++idx) {
+                index_t w = m_heads[idx];
+                real_t w_distance = dist[r] + m_weights[idx];
+                if (w_distance < (dist[w] == REAL_T_MAX ? max_distance : dist[w])) { // Untouched nodes are at max_distance.
+                    state.set_distance(w, w_distance);
+                    queue.push((uint64_t) w_distance, w);
+                }
+            }
+        }
+    }
+
+    // Search upward from the target and meet the upward search from the sources. The search stops when its distances exceed
+    // the shortest distance found, since the distances from the sources only add to them.
+    real_t target_distance(const real_t* source_dist, SearchWorkspace::SearchState& state, index_t target, real_t max_distance) const {
+        real_t best = max_distance;
+        real_t* dist = state.dist.data();
+        auto& queue = state.radix_heap;
+        state.set_distance(target, 0.0);
+        queue.push(0, target);
+        while (!queue.empty()) {
+            uint64_t distance;
+            int_t r;
+            std::tie(distance, r) = queue.pop();
+            if (distance >= best) break;
+            if (distance > dist[r]) continue; // Stale entry.
+            if (source_dist[r] != REAL_T_MAX) best = std::min(best, dist[r] + source_dist[r]);
+            for (index_t idx = m_offsets[r]; idx < m_offsets[r + 1]; ++idx) {
+                index_t w = m_heads[idx];
+                real_t w_distance = dist[r] + m_weights[idx];
+                if (w_distance < (dist[w] == REAL_T_MAX ? best : dist[w])) {
+                    state.set_distance(w, w_distance);
+                    queue.push((uint64_t) w_distance, w);
+                }
+            }
+        }
+        state.reset();
+        return best;
+    }
+
+    // Complete the distances of an upward search to all nodes. Going down in rank order, the upward neighbors of each node have
+    // their final distances.
+    void downward_sweep(real_t* dist, real_t max_distance) const {
+        for (std::size_t r = size(); r-- > 0; ) {
+            real_t distance = dist[r] == REAL_T_MAX ? max_distance : dist[r];
+            for (index_t idx = m_offsets[r]; idx < m_offsets[r + 1]; ++idx) {
+                if (dist[m_heads[idx]] != REAL_T_MAX) distance = std::min(distance, dist[m_heads[idx]] + m_weights[idx]);
+            }
+            if (distance < max_distance) dist[r] = distance;
+        }
+    }
+
+    // Call f for each word following the header of the file.
+    template <typename F>
+    void for_each_word(F f) const {
+        for (auto rank : m_ranks) f(rank);
+        for (auto offset : m_offsets) f(offset);
+        for (std::size_t idx = 0; idx < m_heads.size(); ++idx) {
+            f(m_heads[idx]);
+            f((uint64_t) m_weights[idx]);
+        }
+    }
+
+    static uint64_t graph_checksum(const Graph& graph) {
+        uint64_t h = (FNV_OFFSET_BASIS ^ graph.size()) * FNV_PRIME;
+        for (std::size_t v = 0; v < graph.size(); ++v) {
+            h = (h ^ graph.degree(v)) * FNV_PRIME;
+            graph.for_each_neighbor(v, [&h](int_t w, real_t weight) {
+                h = (h ^ w) * FNV_PRIME;
+                h = (h ^ (uint64_t) weight) * FNV_PRIME;
+            });
+        }
+        return h;
+    }
+
+    static void write_word(std::ofstream& ofs, uint64_t word) {
+        char bytes[8];
+        for (int i = 0; i < 8; ++i) bytes[i] = (word >> (8 * i)) & 0xff;
+        ofs.write(bytes, 8);
+    }
+
+    static uint64_t read_word(std::ifstream& ifs) {
+        unsigned char bytes[8] = {};
+        ifs.read(reinterpret_cast<char*>(bytes), 8);
+        uint64_t word = 0;
+        for (int i = 0; i < 8; ++i) word |= (uint64_t) bytes[i] << (8 * i);
+        return word;
+    }
+
+};
@@ -0,0 +1,44 @@
+/*
+    In-process construction of the compacted de Bruijn graph and the single genome graphs from a GFA1 file.
+    The file is parsed with gfa1_parser's parser and the graphs are built from its containers directly,
+    so that gfa1_parser's output files are written only if asked for.
+    The parser's classes are only visible to the translation unit implementing this class.
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Graph.hpp"
+#include "SingleGenomeGraph.hpp"
+#include "types.hpp"
+
+class Gfa1Graphs {
+public:
+    Gfa1Graphs();
+    ~Gfa1Graphs();
+
+    // Parse the GFA1 file. If out_stem is not empty, gfa1_parser's output files are written with it as well.
+    // With a memory budget of max_memory bytes (0 for none), the links and path lines are spilled to tmp_directory past their shares.
+    bool read(const std::string& gfa1_filename, const std::string& out_stem, std::size_t n_threads,
+              uint64_t max_memory = 0, const std::string& tmp_directory = "");
+
+    // Construct the compacted de Bruijn graph after read().
+    Graph build_cdbg(int_t kmer_length);
+
+    std::size_t n_sggs() const;
+
+    // Construct the single genome graphs i, ..., i + sg_graphs.size() - 1 from the paths in parallel. Must be called with consecutive batches.
+    bool build_sggs(const Graph& cdbg, std::size_t i, std::vector<SingleGenomeGraph>& sg_graphs);
+
+    // Finish the remaining paths and gfa1_parser's output files, if they are being written.
+    bool finish();
+
+private:
+    struct State;
+    std::unique_ptr<State> m_state;
+
+};
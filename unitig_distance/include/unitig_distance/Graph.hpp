@@ -1,55 +1,47 @@
+/*
+    Undirected weighted graph in compressed sparse row (CSR) form.
+    Nodes and edges are first added to an edge list, which finalize() sorts and deduplicates into the immutable adjacency arrays,
+    keeping the smallest weight of duplicate edges. The neighbors of each node are then stored in increasing order.
+    Node ids and offsets are stored as index_t, and the weights as 32-bit integers if they all are integers that fit,
+    which is always the case for compacted de Bruijn graphs and single genome graphs.
+    Searches on graphs with integer weights from sources at integer distances use a radix heap, others a 4-ary heap.
+    A bidirectional search between a few sources and targets alternates searches from both ends and stops when they meet,
+    exploring two small balls instead of one large ball around the sources.
+*/
 #pragma once
 
 #include <algorithm>
-#include <fstream>
+#include <cmath>
+#include <cstdint>
 #include <iostream>
-#include <set>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <vector>
 
+#include "DaryHeap.hpp"
+#include "RadixHeap.hpp"
+#include "SearchWorkspace.hpp"
 #include "types.hpp"
 #include "Utils.hpp"
 
-using edges_t = std::vector<std::pair<int_t, real_t>>;
-using edges_itr_t = typename edges_t::iterator;
-using edges_const_itr_t = typename edges_t::const_iterator;
-
-using adj_itr_t = typename std::vector<edges_t>::iterator;
-using adj_const_itr_t = typename std::vector<edges_t>::const_iterator;
-
 class Graph {
 public:
     Graph() : Graph(false, false) { }
     ~Graph() = default;
     Graph(const Graph& other) = default;
-    Graph(Graph&& other)
-    : m_adj(std::move(other.m_adj)),
-      m_self_edge_weights(std::move(other.m_self_edge_weights)),
-      m_one_based(other.m_one_based),
-      m_two_sided(other.m_two_sided)
-    { }
+    Graph(Graph&& other) = default;
 
-    Graph(bool one_based, bool two_sided = false) : m_adj(), m_self_edge_weights(), m_one_based(one_based), m_two_sided(two_sided) { }
+    Graph(bool one_based, bool two_sided = false) : m_n_nodes(0), m_one_based(one_based), m_two_sided(two_sided) { }
 
-    bool contains(int_t v) const { return v < (int_t) m_adj.size(); }
+    bool contains(int_t v) const { return v < (int_t) size(); }
 
-    void add_node() { m_adj.emplace_back(); }
+    // Functions for constructing the graph, which is usable after finalize().
+    void add_node() { ++m_n_nodes; }
 
     void add_edge(int_t v, int_t w, real_t weight) {
         if (v == w) return;
-        auto it = find_edge(v, w);
-        if (it == end(v)) {
-            // New edge.
-            (*this)[v].emplace_back(w, weight);
-            (*this)[w].emplace_back(v, weight);
-        } else {
-            // Edge exists, update to shorter edge weight.
-            auto current_weight = it->second;
-            if (current_weight <= weight) return;
-            it->second = weight;
-            find_edge(w, v)->second = weight;
-        }
+        m_edge_list.push_back(Edge{(index_t) std::min(v, w), (index_t) std::max(v, w), weight});
     }
 
     void add_two_sided_node(real_t self_edge_weight) {
@@ -59,27 +51,69 @@ public:
         m_self_edge_weights.push_back(self_edge_weight);
     }
 
-    bool has_edge(int_t v, int_t w) const { return find_edge(v, w) != end(v); }
+    void resize(std::size_t sz) { m_n_nodes = sz; }
 
-    void remove_edge(int_t v, int_t w) {
-        auto it = find_edge(v, w);
-        if (it != end(v)) {
-            (*this)[v].erase(it);
-            auto it2 = find_edge(w, v);
-            (*this)[w].erase(it2);
+    // Build the adjacency arrays from the edge list. Returns false if the graph is too large for index_t.
+    bool finalize() {
+        if (m_n_nodes >= INDEX_T_MAX || 2 * m_edge_list.size() >= INDEX_T_MAX) {
+            std::cerr << "Error: Graph with " << m_n_nodes << " nodes and " << m_edge_list.size() << " edges is too large, build with 'make LARGE_GRAPHS=1'." << std::endl;
+            return false;
         }
+        // Sort by endpoints and weight, so that the first of duplicate edges has the smallest weight.
+        std::sort(m_edge_list.begin(), m_edge_list.end(), [](const Edge& a, const Edge& b) {
+            return std::tie(a.v, a.w, a.weight) < std::tie(b.v, b.w, b.weight);
+        });
+        m_edge_list.erase(std::unique(m_edge_list.begin(), m_edge_list.end(), [](const Edge& a, const Edge& b) {
+            return a.v == b.v && a.w == b.w;
+        }), m_edge_list.end());
+
+        bool integer_weights = std::all_of(m_edge_list.begin(), m_edge_list.end(), [](const Edge& edge) {
+            return edge.weight >= 0.0 && edge.weight <= UINT32_MAX && std::floor(edge.weight) == edge.weight;
+        });
+
+        m_offsets.assign(m_n_nodes + 1, 0);
+        for (const auto& edge : m_edge_list) {
+            ++m_offsets[edge.v + 1];
+            ++m_offsets[edge.w + 1];
+        }
+        for (std::size_t v = 0; v < m_n_nodes; ++v) m_offsets[v + 1] += m_offsets[v];
+        m_heads.resize(m_offsets.back());
+        if (integer_weights) m_integer_weights.resize(m_heads.size());
+        else m_real_weights.resize(m_heads.size());
+
+        // Edges (v, w) are sorted with v < w, so every node gets its smaller neighbors first, in increasing order, and then the larger ones.
+        std::vector<index_t> next(m_offsets.begin(), m_offsets.end() - 1);
+        auto add_half_edge = [this, integer_weights, &next](index_t v, index_t w, real_t weight) {
+            index_t idx = next[v]++;
+            m_heads[idx] = w;
+            if (integer_weights) m_integer_weights[idx] = weight;
+            else m_real_weights[idx] = weight;
+        };
+        for (const auto& edge : m_edge_list) {
+            add_half_edge(edge.v, edge.w, edge.weight);
+            add_half_edge(edge.w, edge.v, edge.weight);
+        }
+        Utils::clear(m_edge_list);
+        return true;
     }
 
-    void disconnect_node(int_t v) {
-        auto adj_v = (*this)[v];
-        for (auto w : adj_v) remove_edge(v, w.first);
+    // Adjacency accessors.
+    int_t degree(int_t v) const { return m_offsets[v + 1] - m_offsets[v]; }
+    int_t neighbor(int_t v, int_t idx) const { return m_heads[m_offsets[v] + idx]; }
+    real_t weight(int_t v, int_t idx) const { return edge_weight(m_offsets[v] + idx); }
+
+    // Call f(w, weight) for the neighbors w of v.
+    template <typename F>
+    void for_each_neighbor(int_t v, F f) const {
+        for (index_t idx = m_offsets[v]; idx < m_offsets[v + 1]; ++idx) f((int_t) m_heads[idx], edge_weight(idx));
     }
 
-    int_t degree(int_t v) const { return (*this)[v].size(); }
+    std::size_t size() const { return m_n_nodes; }
 
-    std::size_t size() const { return m_adj.size(); }
+    std::size_t n_edges() const { return m_heads.size() / 2; }
 
-    void resize(std::size_t sz) { m_adj.resize(sz); }
+    // True if the edge weights are stored as integers. Empty graphs have integer weights.
+    bool integer_weights() const { return m_real_weights.empty(); }
 
     // Useful functions if graph stores two sides for each node.
     std::size_t true_size() const { return size() / 2; }
@@ -105,23 +139,11 @@ public:
             max_degree = std::max(max_degree, sz);
         }
         std::string out_str = "Graph has " +  Utils::neat_number_str(n_nodes) + " connected" + (two_sided() ? " (half) " : " ") + "nodes and "
-                            + Utils::neat_number_str(n_edges / 2) + " edges. Avg and max degree are " 
+                            + Utils::neat_number_str(n_edges / 2) + " edges. Avg and max degree are "
                             + Utils::neat_decimal_str(n_edges, n_nodes) + " and " + std::to_string(max_degree) + ".";
         std::cout << out_str << std::endl;
     }
 
-    // Accessors and iterators.
-    edges_t& operator[](std::size_t idx) { return m_adj[idx]; }
-    const edges_t& operator[](std::size_t idx) const { return m_adj[idx]; }
-    adj_itr_t begin() { return m_adj.begin(); }
-    adj_itr_t end() { return m_adj.end(); }
-    adj_const_itr_t begin() const { return m_adj.begin(); }
-    adj_const_itr_t end() const { return m_adj.end(); }
-    edges_itr_t begin(int_t v) { return m_adj[v].begin(); }
-    edges_itr_t end(int_t v) { return m_adj[v].end(); }
-    edges_const_itr_t begin(int_t v) const { return m_adj[v].begin(); }
-    edges_const_itr_t end(int_t v) const { return m_adj[v].end(); }
-
     void swap(Graph& other) {
         Graph tmp = std::move(*this);
         *this = std::move(other);
@@ -129,13 +151,7 @@ public:
     }
 
     Graph& operator=(const Graph& other) = delete;
-    Graph& operator=(Graph&& other) {
-        m_adj = std::move(other.m_adj);
-        m_self_edge_weights = std::move(other.m_self_edge_weights);
-        m_one_based = other.m_one_based;
-        m_two_sided = other.m_two_sided;
-        return *this;
-    }
+    Graph& operator=(Graph&& other) = default;
 
     // Compute the shortest distance between a source and a target.
     real_t distance(int_t source, int_t target, real_t max_distance = REAL_T_MAX) const {
@@ -148,25 +164,102 @@ public:
         const std::vector<int_t>& targets,
         real_t max_distance = REAL_T_MAX) const
     {
-        std::vector<real_t> dist(size(), max_distance);
+        SearchWorkspace workspace;
+        workspace.sources() = sources;
+        workspace.targets() = targets;
+        distance(workspace, max_distance);
+        return workspace.target_dist();
+    }
+
+    // Same as above with the sources and targets given in the workspace, which also gets the results. Workspaces should be reused across searches.
+    void distance(SearchWorkspace& workspace, real_t max_distance = REAL_T_MAX) const { search(workspace, max_distance, nullptr); }
+
+    // Compute the shortest distances from the sources in the workspace to all nodes, REAL_T_MAX for the nodes that can't be reached.
+    void distances(SearchWorkspace& workspace, std::vector<real_t>& dist) const {
+        workspace.targets().clear();
+        search(workspace, REAL_T_MAX, &dist);
+    }
 
-        std::vector<bool> is_target(size());
-        for (auto w : targets) is_target[w] = true;
-        int_t targets_left = targets.size();
+    // Compute the shortest distance between the sources and the nearest of the targets in the workspace, or max_distance if
+    // there is none closer, with a bidirectional search. Both sides of two-sided nodes should be given as sources or targets.
+    // Graphs with real weights use the one-to-many search, which sums the weights along a path in the same order for every query.
+    real_t bidirectional_distance(SearchWorkspace& workspace, real_t max_distance = REAL_T_MAX) const {
+        if (!integer_weights() || !integer_sources(workspace)) {
+            distance(workspace, max_distance);
+            const auto& target_dist = workspace.target_dist();
+            return target_dist.empty() ? max_distance : *std::min_element(target_dist.begin(), target_dist.end());
+        }
+        return bidirectional_dijkstra(workspace, max_distance);
+    }
+
+private:
+    struct Edge {
+        index_t v;
+        index_t w;
+        real_t weight;
+    };
+
+    // Edges added before finalize().
+    std::vector<Edge> m_edge_list;
+
+    std::size_t m_n_nodes;
 
-        std::set<std::pair<real_t, int_t>> queue; // (distance, node) pairs.
-        for (auto s : sources) {
+    // The neighbors of node v are m_heads[m_offsets[v]], ..., m_heads[m_offsets[v + 1] - 1], with the weights at the same indices.
+    std::vector<index_t> m_offsets;
+    std::vector<index_t> m_heads;
+    std::vector<uint32_t> m_integer_weights;
+    std::vector<real_t> m_real_weights;
+
+    // Filled if graph nodes are two-sided.
+    std::vector<real_t> m_self_edge_weights;
+
+    bool m_one_based;
+    bool m_two_sided;
+
+    real_t edge_weight(index_t idx) const { return integer_weights() ? m_integer_weights[idx] : m_real_weights[idx]; }
+
+    void search(SearchWorkspace& workspace, real_t max_distance, std::vector<real_t>* all_dist) const {
+        auto& forward = workspace.m_forward;
+        if (integer_weights() && integer_sources(workspace)) dijkstra(m_integer_weights, forward.radix_heap, workspace, max_distance, all_dist);
+        else if (integer_weights()) dijkstra(m_integer_weights, forward.dary_heap, workspace, max_distance, all_dist);
+        else dijkstra(m_real_weights, forward.dary_heap, workspace, max_distance, all_dist);
+    }
+
+    // True if the initial distances of the sources are integers that the radix heap keys can hold exactly.
+    static bool integer_sources(const SearchWorkspace& workspace) {
+        const auto& sources = workspace.sources();
+        return std::all_of(sources.begin(), sources.end(), [](const std::pair<int_t, real_t>& source) {
+            return source.second >= 0.0 && source.second < 9007199254740992.0 && std::floor(source.second) == source.second;
+        });
+    }
+
+    // Dijkstra's algorithm with lazy deletion: a node is pushed again when its distance decreases and stale entries are skipped.
+    // The distances to all nodes are copied to all_dist if it's set.
+    template <typename weight_t, typename queue_t>
+    void dijkstra(const std::vector<weight_t>& weights, queue_t& queue, SearchWorkspace& workspace, real_t max_distance, std::vector<real_t>* all_dist) const {
+        workspace.reserve(size());
+        auto& forward = workspace.m_forward;
+        real_t* dist = forward.dist.data(); // Not resized during the search.
+
+        auto& is_target = workspace.m_is_target;
+        for (auto w : workspace.targets()) is_target[w] = true;
+        int_t targets_left = workspace.targets().size();
+
+        using queue_key_t = typename queue_t::key_type;
+        for (auto s : workspace.sources()) {
             int_t v;
             real_t initial_distance;
             std::tie(v, initial_distance) = s;
-            dist[v] = initial_distance;
-            queue.emplace(initial_distance, v);
+            forward.set_distance(v, initial_distance);
+            queue.push((queue_key_t) initial_distance, v);
         }
 
         // Start search.
         while (!queue.empty()) {
-            auto v = queue.begin()->second;
-            queue.erase(queue.begin());
+            queue_key_t distance;
+            int_t v;
+            std::tie(distance, v) = queue.pop();
+            if (distance > dist[v]) continue; // Stale entry.
             if (is_target[v]) {
                 --targets_left;
                 is_target[v] = false;
@@ -175,42 +268,71 @@ public:
                     is_target[other_side(v)] = false;
                 }
                 if (targets_left == 0) break; // Calculated distances for all targets.
-            }            
-            for (auto vw : (*this)[v]) {
-                int_t w;
-                real_t weight;
-                std::tie(w, weight) = vw;
-                if (dist[v] + weight < dist[w]) {
-                    queue.erase({dist[w], w});
-                    dist[w] = dist[v] + weight;
-                    queue.insert({dist[w], w});
+            }
+            for (index_t idx = m_offsets[v]; idx < m_offsets[v + 1]; ++idx) {
+                int_t w = m_heads[idx];
+                real_t w_distance = dist[v] + weights[idx];
+                if (w_distance < (dist[w] == REAL_T_MAX ? max_distance : dist[w])) { // Untouched nodes are at max_distance.
+                    forward.set_distance(w, w_distance);
+                    queue.push((queue_key_t) w_distance, w);
                 }
             }
         }
-        std::vector<real_t> target_dist;
-        for (auto target : targets) target_dist.push_back(dist[target]);
-        return target_dist;
+        auto& target_dist = workspace.m_target_dist;
+        target_dist.clear();
+        for (auto target : workspace.targets()) target_dist.push_back(dist[target] == REAL_T_MAX ? max_distance : dist[target]);
+        if (all_dist != nullptr) all_dist->assign(dist, dist + size());
+        workspace.reset();
     }
 
-private:
-    std::vector<edges_t> m_adj;
-
-    // Filled if graph nodes are two-sided.
-    std::vector<real_t> m_self_edge_weights;
+    // Bidirectional Dijkstra's algorithm on integer weights. Each step settles a node on the side with the smaller queue, and
+    // every edge scanned into a node reached from the other side gives a candidate for the shortest distance. The search stops
+    // when the smallest keys of the two queues sum to at least the best candidate, since no path through unsettled nodes on
+    // both sides can then be shorter. Each side only keeps distances below max_distance, which both halves of a shorter path are.
+    real_t bidirectional_dijkstra(SearchWorkspace& workspace, real_t max_distance) const {
+        auto& forward = workspace.m_forward;
+        auto& backward = workspace.m_backward;
+        forward.reserve(size());
+        backward.reserve(size());
+
+        for (auto s : workspace.sources()) {
+            forward.set_distance(s.first, s.second);
+            forward.radix_heap.push((uint64_t) s.second, s.first);
+        }
+        real_t best = max_distance;
+        for (auto w : workspace.targets()) {
+            backward.set_distance(w, 0.0);
+            backward.radix_heap.push(0, w);
+            if (forward.dist[w] != REAL_T_MAX) best = std::min(best, forward.dist[w]); // Target is also a source.
+        }
 
-    bool m_one_based;
-    bool m_two_sided;
+        while (true) {
+            real_t forward_key = forward.radix_heap.empty() ? REAL_T_MAX : forward.radix_heap.top_key();
+            real_t backward_key = backward.radix_heap.empty() ? REAL_T_MAX : backward.radix_heap.top_key();
+            if (forward_key == REAL_T_MAX || backward_key == REAL_T_MAX || forward_key + backward_key >= best) break;
 
-    edges_itr_t find_edge(int_t v, int_t w) {
-        auto it = begin(v);
-        while (it != end(v) && it->first != w) ++it;
-        return it;
-    }
+            bool expand_forward = forward.radix_heap.size() <= backward.radix_heap.size();
+            auto& side = expand_forward ? forward : backward;
+            const real_t* other_dist = (expand_forward ? backward : forward).dist.data();
+            real_t* dist = side.dist.data();
 
-    edges_const_itr_t find_edge(int_t v, int_t w) const {
-        auto it = begin(v);
-        while (it != end(v) && it->first != w) ++it;
-        return it;
+            uint64_t distance;
+            int_t v;
+            std::tie(distance, v) = side.radix_heap.pop();
+            if (distance > dist[v]) continue; // Stale entry.
+            for (index_t idx = m_offsets[v]; idx < m_offsets[v + 1]; ++idx) {
+                int_t w = m_heads[idx];
+                real_t w_distance = dist[v] + m_integer_weights[idx];
+                if (other_dist[w] != REAL_T_MAX) best = std::min(best, w_distance + other_dist[w]);
+                if (w_distance < (dist[w] == REAL_T_MAX ? max_distance : dist[w])) { // Untouched nodes are at max_distance.
+                    side.set_distance(w, w_distance);
+                    side.radix_heap.push((uint64_t) w_distance, w);
+                }
+            }
+        }
+        forward.reset();
+        backward.reset();
+        return best;
     }
 
 };
@@ -2,10 +2,12 @@
 
 #include <fstream>
 #include <iostream>
+#include <istream>
 #include <string>
 #include <tuple>
 #include <vector>
 
+#include "BinaryGraph.hpp"
 #include "Graph.hpp"
 #include "ProgramOptions.hpp"
 #include "types.hpp"
@@ -37,12 +39,14 @@ public:
             std::tie(v, w, weight) = edge;
             graph.add_edge(v, w, weight);
         }
+        if (!graph.finalize()) return Graph();
         return graph;
     }
 
     /* Construct a compacted de Bruijn graph constructed from multiple genome references.
-       This graph stores two nodes for each unitig: one for its left side and one for its right side, considered from the canonical form. */
-    static Graph build_cdbg(const std::string& unitigs_filename, const std::string& edges_filename, int_t kmer_length, bool one_based = false) {
+       This graph stores two nodes for each unitig: one for its left side and one for its right side, considered from the canonical form.
+       The unitigs file has lines "id sequence", or "id length" if lengths_file is set. */
+    static Graph build_cdbg(const std::string& unitigs_filename, const std::string& edges_filename, int_t kmer_length, bool one_based = false, bool lengths_file = false) {
         Graph graph(one_based, true);
         std::ifstream ifs_unitigs(unitigs_filename);
         for (std::string line; std::getline(ifs_unitigs, line); ) {
@@ -51,7 +55,8 @@ public:
                 std::cerr << "Error: Wrong number of fields in compacted de Bruijn graph unitigs file: " << unitigs_filename << std::endl;
                 return Graph();
             }
-            real_t self_edge_weight = (real_t) fields[1].size() - kmer_length;
+            int_t unitig_length = lengths_file ? std::stoll(fields[1]) : fields[1].size();
+            real_t self_edge_weight = (real_t) unitig_length - kmer_length;
             if (self_edge_weight < 0.0) {
                 std::cerr << "self_edge_weight = " << self_edge_weight << " < 0.0 -- wrong k-mer length?" << std::endl;
                 return Graph();
@@ -73,19 +78,46 @@ public:
             int_t w = 2 * (std::stoll(fields[1]) - one_based) + (edge_type[1] == 'R'); // *R edge means link goes to w's right side.
             graph.add_edge(v, w, 1.0); // Weight 1.0 by definition.
         }
+        if (!graph.finalize()) return Graph();
         return graph;
     }
 
-    // Construct an edge-induced subgraph from the compacted de Bruijn graph. Will be used to construct a single genome graph.
-    static Graph build_cdbg_subgraph(const Graph& cdbg, const std::string& edges_filename) {
-        if (!cdbg.two_sided()) {
-            std::cerr << "Error: build_cdbg_subgraph called with non-two-sided graph." << std::endl;
+    // Construct a compacted de Bruijn graph from a binary graph file, which holds both the unitig lengths and the edges.
+    static Graph build_cdbg_binary(const std::string& binary_graph_filename, int_t kmer_length) {
+        BinaryGraph binary_graph;
+        if (!binary_graph.open(binary_graph_filename)) {
+            std::cerr << "Error: Invalid binary graph file: " << binary_graph_filename << std::endl;
             return Graph();
         }
-        Graph graph(cdbg.one_based(), false);
-        std::vector<std::pair<int_t, int_t>> edges;
+        Graph graph(false, true);
+        for (std::size_t idx = 0; idx < binary_graph.n_lengths(); ++idx) {
+            real_t self_edge_weight = (real_t) binary_graph.length(idx) - kmer_length;
+            if (self_edge_weight < 0.0) {
+                std::cerr << "self_edge_weight = " << self_edge_weight << " < 0.0 -- wrong k-mer length?" << std::endl;
+                return Graph();
+            }
+            graph.add_two_sided_node(self_edge_weight);
+        }
+        for (std::size_t idx = 0; idx < binary_graph.n_edges(); ++idx) {
+            if (binary_graph.edge_overlap(idx) == 0) continue; // Non-overlapping edges ignored.
+            int_t v = 2 * binary_graph.edge_from(idx) + binary_graph.edge_from_forward(idx);
+            int_t w = 2 * binary_graph.edge_to(idx) + binary_graph.edge_to_reverse(idx);
+            graph.add_edge(v, w, 1.0); // Weight 1.0 by definition.
+        }
+        if (!graph.finalize()) return Graph();
+        return graph;
+    }
+
+    // Construct an edge-induced subgraph from the compacted de Bruijn graph. Will be used to construct a single genome graph.
+    static Graph build_cdbg_subgraph(const Graph& cdbg, const std::string& edges_filename) {
         std::ifstream ifs_edges(edges_filename);
-        int_t max_v = 0;
+        return build_cdbg_subgraph(cdbg, ifs_edges, edges_filename);
+    }
+
+    // Same as above, but the edges are read from a stream, e.g. a block of a packed single genome graphs file.
+    static Graph build_cdbg_subgraph(const Graph& cdbg, std::istream& ifs_edges, const std::string& edges_filename) {
+        std::vector<std::pair<int_t, int_t>> edges;
+        int_t one_based = cdbg.one_based();
         for (std::string line; std::getline(ifs_edges, line); ) {
             auto fields = Utils::get_fields(line);
             if (fields.size() < 3) {
@@ -95,27 +127,57 @@ public:
             bool good_overlap = fields.size() < 4 || std::stoll(fields[3]) != 0;
             if (!good_overlap) continue; // Non-overlapping edges ignored.
             std::string edge_type = fields[2];
-            int_t v = 2 * (std::stoll(fields[0]) - graph.one_based()) + (edge_type[0] == 'F'); // F* edge means link comes from v's right side.
-            int_t w = 2 * (std::stoll(fields[1]) - graph.one_based()) + (edge_type[1] == 'R'); // *R edge means link goes to w's right side.
+            int_t v = 2 * (std::stoll(fields[0]) - one_based) + (edge_type[0] == 'F'); // F* edge means link comes from v's right side.
+            int_t w = 2 * (std::stoll(fields[1]) - one_based) + (edge_type[1] == 'R'); // *R edge means link goes to w's right side.
             edges.emplace_back(v, w);
-            max_v = std::max(max_v, std::max(v, w));
         }
-        graph.resize((max_v | 1) + 1);
+        return build_cdbg_subgraph(cdbg, edges);
+    }
+
+    // Same as above, but the edges are read from a binary graph, e.g. a binary block of a packed single genome graphs file.
+    static Graph build_cdbg_subgraph(const Graph& cdbg, const BinaryGraph& binary_graph) {
+        std::vector<std::pair<int_t, int_t>> edges;
+        edges.reserve(binary_graph.n_edges());
+        for (std::size_t idx = 0; idx < binary_graph.n_edges(); ++idx) {
+            if (binary_graph.edge_overlap(idx) == 0) continue; // Non-overlapping edges ignored.
+            int_t v = 2 * binary_graph.edge_from(idx) + binary_graph.edge_from_forward(idx);
+            int_t w = 2 * binary_graph.edge_to(idx) + binary_graph.edge_to_reverse(idx);
+            edges.emplace_back(v, w);
+        }
+        return build_cdbg_subgraph(cdbg, edges);
+    }
 
+    // Same as above, but the edges are given as (v, w) pairs of node sides, e.g. straight from an in-process parser.
+    static Graph build_cdbg_subgraph(const Graph& cdbg, const std::vector<std::pair<int_t, int_t>>& edges) {
+        if (!cdbg.two_sided()) {
+            std::cerr << "Error: build_cdbg_subgraph called with non-two-sided graph." << std::endl;
+            return Graph();
+        }
+        Graph graph(cdbg.one_based(), false);
+        int_t max_v = 0;
+        for (const auto& edge : edges) max_v = std::max(max_v, std::max(edge.first, edge.second));
+        graph.resize((max_v | 1) + 1);
+        std::vector<bool> has_self_edge(graph.true_size());
         for (const auto& edge : edges) {
             int_t v, w;
             std::tie(v, w) = edge;
             // Get self-edges from the original graph.
-            if (graph.degree(v) == 0) graph.add_edge(v, graph.other_side(v), cdbg.get_self_edge_weight(v));
-            if (graph.degree(w) == 0) graph.add_edge(w, graph.other_side(w), cdbg.get_self_edge_weight(w));
+            if (!has_self_edge[v / 2]) graph.add_edge(v, graph.other_side(v), cdbg.get_self_edge_weight(v));
+            if (!has_self_edge[w / 2]) graph.add_edge(w, graph.other_side(w), cdbg.get_self_edge_weight(w));
+            has_self_edge[v / 2] = has_self_edge[w / 2] = true;
             graph.add_edge(v, w, 1.0); // Weight 1.0 by definition.
         }
+        if (!graph.finalize()) return Graph();
         return graph;
     }
 
     static Graph build_correct_graph() {
         if (ProgramOptions::has_operating_mode(OperatingMode::GENERAL)) return build_ordinary_graph(ProgramOptions::edges_filename, ProgramOptions::graphs_one_based);
-        if (ProgramOptions::has_operating_mode(OperatingMode::CDBG)) return build_cdbg(ProgramOptions::unitigs_filename, ProgramOptions::edges_filename, ProgramOptions::k, ProgramOptions::graphs_one_based);
+        if (ProgramOptions::has_operating_mode(OperatingMode::CDBG)) {
+            if (ProgramOptions::binary_graph) return build_cdbg_binary(ProgramOptions::edges_filename, ProgramOptions::k);
+            if (ProgramOptions::unitigs_filename.empty()) return build_cdbg(ProgramOptions::lengths_filename, ProgramOptions::edges_filename, ProgramOptions::k, ProgramOptions::graphs_one_based, true);
+            return build_cdbg(ProgramOptions::unitigs_filename, ProgramOptions::edges_filename, ProgramOptions::k, ProgramOptions::graphs_one_based);
+        }
         std::cout << "Error: Program logic error." << std::endl;
         return Graph();
     }
@@ -6,46 +6,89 @@
 #include <utility>
 #include <vector>
 
+#include "ContractionHierarchy.hpp"
 #include "Distance.hpp"
 #include "DistanceVector.hpp"
 #include "Graph.hpp"
+#include "Landmarks.hpp"
 #include "PrintUtils.hpp"
 #include "ProgramOptions.hpp"
 #include "SearchJobs.hpp"
+#include "SearchWorkspace.hpp"
 #include "Timer.hpp"
 #include "types.hpp"
 
 class GraphDistances {
 public:
     GraphDistances() = delete;
-    GraphDistances(const Graph& graph, const Timer& timer)
+    GraphDistances(const Graph& graph, const Timer& timer, const ContractionHierarchy* ch = nullptr, const Landmarks* landmarks = nullptr)
     : m_graph(graph),
-      m_timer(timer)
+      m_timer(timer),
+      m_ch(ch),
+      m_landmarks(landmarks)
     { }
 
     // Calculate distances for general graphs and compacted de Bruijn graphs.
     DistanceVector solve(const SearchJobs& search_jobs) {
         DistanceVector res(search_jobs.n_queries(), REAL_T_MAX);
+        std::vector<SearchWorkspace> workspaces(ProgramOptions::n_threads);
 
-        auto calculate_distance_block = [this, &search_jobs, &res](std::size_t thr, std::size_t block_start, std::size_t block_end) {
+        auto calculate_distance_block = [this, &search_jobs, &res, &workspaces](std::size_t thr, std::size_t block_start, std::size_t block_end) {
             bool two_sided = m_graph.two_sided();
+            auto& workspace = workspaces[thr];
+            std::vector<std::size_t> w_idxs; // Indices of the job's targets that are searched.
+            bool use_astar = m_landmarks != nullptr && ProgramOptions::max_distance == REAL_T_MAX;
             for (std::size_t i = thr + block_start; i < block_end; i += ProgramOptions::n_threads) {
                 const auto& job = search_jobs[i];
 
                 auto v = job.v();
                 if ((two_sided && !m_graph.contains(m_graph.left_node(v))) || !m_graph.contains(v)) continue;
+                set_sources(workspace, v);
 
-                auto sources = get_sources(v);
-                auto targets = get_targets(job.ws());
-                auto target_dist = m_graph.distance(sources, targets, ProgramOptions::max_distance);
-
+                // Targets not in the graph are skipped, and with landmarks also those that are surely at least max_distance away.
+                w_idxs.clear();
                 for (std::size_t w_idx = 0; w_idx < job.size(); ++w_idx) {
-                    auto original_idx = job.original_index(w_idx);
+                    auto w = job.ws()[w_idx];
+                    if ((two_sided && !m_graph.contains(m_graph.right_node(w))) || !m_graph.contains(w)) continue;
+                    if (m_landmarks != nullptr) {
+                        workspace.targets().clear();
+                        add_target(workspace, w);
+                        if (m_landmarks->lower_bound(workspace) >= ProgramOptions::max_distance) {
+                            res[job.original_index(w_idx)] = ProgramOptions::max_distance;
+                            continue;
+                        }
+                    }
+                    w_idxs.push_back(w_idx);
+                }
+                if (w_idxs.empty()) continue;
+
+                if (m_ch == nullptr && w_idxs.size() <= BIDIRECTIONAL_MAX_TARGETS) {
+                    // Searching from both ends for each target explores far less than one search around v that reaches all of them.
+                    // Without a maximum distance, an A* search guided by the landmarks explores less still, but two searches to half
+                    // of a short maximum distance are cheaper than one search to the whole of it.
+                    for (auto w_idx : w_idxs) {
+                        workspace.targets().clear();
+                        add_target(workspace, job.ws()[w_idx]);
+                        res[job.original_index(w_idx)] = use_astar
+                            ? m_landmarks->distance(m_graph, workspace, ProgramOptions::max_distance)
+                            : m_graph.bidirectional_distance(workspace, ProgramOptions::max_distance);
+                    }
+                    continue;
+                }
+
+                workspace.targets().clear();
+                for (auto w_idx : w_idxs) add_target(workspace, job.ws()[w_idx]);
+                if (m_ch != nullptr) m_ch->distance(workspace, ProgramOptions::max_distance);
+                else m_graph.distance(workspace, ProgramOptions::max_distance);
+                const auto& target_dist = workspace.target_dist();
+
+                for (std::size_t t_idx = 0; t_idx < w_idxs.size(); ++t_idx) {
+                    auto original_idx = job.original_index(w_idxs[t_idx]);
                     if (two_sided) {
-                        // target_dist contains w's both sides for each w_idx.
-                        res[original_idx] = std::min(target_dist[w_idx * 2], target_dist[w_idx * 2 + 1]);
+                        // target_dist contains w's both sides for each searched w.
+                        res[original_idx] = std::min(target_dist[t_idx * 2], target_dist[t_idx * 2 + 1]);
                     } else {
-                        res[original_idx] = target_dist[w_idx];
+                        res[original_idx] = target_dist[t_idx];
                     }
                 }
             }
@@ -64,33 +107,35 @@ public:
     }
 
 private:
+    // Jobs with at most this many targets use a bidirectional or an A* search for each target.
+    static const std::size_t BIDIRECTIONAL_MAX_TARGETS = 2;
+
     const Graph& m_graph;
     const Timer& m_timer;
+    const ContractionHierarchy* m_ch; // Used for the searches if set.
+    const Landmarks* m_landmarks; // Bound the distances and guide the searches for few targets if set.
 
     bool m_verbose;
     
-    std::vector<std::pair<int_t, real_t>> get_sources(int_t v) {
-        std::vector<std::pair<int_t, real_t>> sources;
+    void set_sources(SearchWorkspace& workspace, int_t v) {
+        auto& sources = workspace.sources();
+        sources.clear();
         if (m_graph.two_sided()) {
             sources.emplace_back(m_graph.left_node(v), 0.0);
             sources.emplace_back(m_graph.right_node(v), 0.0);
         } else {
             sources.emplace_back(v, 0.0);
         }
-        return sources;
     }
 
-    std::vector<int_t> get_targets(const std::vector<int_t>& ws) {
-        std::vector<int_t> targets;
-        for (auto w : ws) {
-            if (m_graph.two_sided()) {
-                targets.push_back(m_graph.left_node(w));
-                targets.push_back(m_graph.right_node(w));
-            } else {
-                targets.push_back(w);
-            }
+    void add_target(SearchWorkspace& workspace, int_t w) {
+        auto& targets = workspace.targets();
+        if (m_graph.two_sided()) {
+            targets.push_back(m_graph.left_node(w));
+            targets.push_back(m_graph.right_node(w));
+        } else {
+            targets.push_back(w);
         }
-        return targets;
     }
 
 };
@@ -0,0 +1,242 @@
+/*
+    Landmarks for goal-directed (ALT) searches in a graph with integer weights. The distances from each landmark to all nodes are
+    stored, and by the triangle inequality |d(L, v) - d(L, w)| <= d(v, w) <= d(L, v) + d(L, w) for every landmark L.
+    Two nodes of which only one is reached from a landmark are in different components and thus not connected.
+    The lower bounds guide A* searches toward their targets and let queries skip targets that are at least max_distance away.
+
+    Landmarks are selected either by farthest-point selection, each landmark being the node farthest from the previous ones, or as
+    the nodes of highest degree. Farthest-point selection needs the distances from each landmark before choosing the next one, so
+    its searches run one at a time, while the searches from the highest degree nodes run in parallel.
+    The tables store the distances of each node next to each other as 32-bit integers.
+*/
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "Graph.hpp"
+#include "SearchWorkspace.hpp"
+#include "types.hpp"
+#include "Utils.hpp"
+
+class Landmarks {
+public:
+    Landmarks() : m_n_nodes(0) { }
+    Landmarks(const Landmarks& other) = delete;
+    Landmarks& operator=(const Landmarks& other) = delete;
+
+    // Number of landmarks, zero if they haven't been selected.
+    std::size_t size() const { return m_landmarks.size(); }
+
+    // Select at most n_landmarks landmarks and compute their distance tables. Farthest-point selection stops early if the component
+    // of the first landmark has no more nodes. Returns false if the graph has real weights or distances too large for the tables.
+    bool select(const Graph& graph, std::size_t n_landmarks, bool farthest, int_t n_threads = 1) {
+        if (!graph.integer_weights()) {
+            std::cerr << "Error: Landmarks need integer edge weights." << std::endl;
+            return false;
+        }
+        m_n_nodes = graph.size();
+        m_landmarks.clear();
+        n_landmarks = std::min(n_landmarks, m_n_nodes);
+        if (n_landmarks == 0) return true;
+        m_table.assign(m_n_nodes * n_landmarks, (uint32_t) INF);
+        bool ok = farthest ? select_farthest(graph, n_landmarks) : select_highest_degree(graph, n_landmarks, n_threads);
+        if (!ok) {
+            std::cerr << "Error: Graph distances are too large for the landmark tables." << std::endl;
+            m_landmarks.clear();
+            Utils::clear(m_table);
+            return false;
+        }
+        if (m_landmarks.size() < n_landmarks) {
+            // Close the gaps left by the landmarks that weren't selected.
+            for (std::size_t v = 0; v < m_n_nodes; ++v) {
+                for (std::size_t i = 0; i < m_landmarks.size(); ++i) m_table[v * m_landmarks.size() + i] = m_table[v * n_landmarks + i];
+            }
+            m_table.resize(m_n_nodes * m_landmarks.size());
+            m_table.shrink_to_fit();
+        }
+        return true;
+    }
+
+    // Lower bound for the distance between v and w, REAL_T_MAX if they aren't connected.
+    real_t lower_bound(int_t v, int_t w) const {
+        const uint32_t* v_row = row(v);
+        const uint32_t* w_row = row(w);
+        uint32_t bound = 0;
+        for (std::size_t i = 0; i < size(); ++i) {
+            if (v_row[i] == INF || w_row[i] == INF) {
+                if (v_row[i] != w_row[i]) return REAL_T_MAX;
+                continue;
+            }
+            bound = std::max(bound, v_row[i] > w_row[i] ? v_row[i] - w_row[i] : w_row[i] - v_row[i]);
+        }
+        return bound;
+    }
+
+    // Upper bound for the distance between v and w, REAL_T_MAX if no landmark reaches both.
+    real_t upper_bound(int_t v, int_t w) const {
+        const uint32_t* v_row = row(v);
+        const uint32_t* w_row = row(w);
+        real_t bound = REAL_T_MAX;
+        for (std::size_t i = 0; i < size(); ++i) {
+            if (v_row[i] != INF && w_row[i] != INF) bound = std::min(bound, (real_t) v_row[i] + w_row[i]);
+        }
+        return bound;
+    }
+
+    // Lower bound for the distance between the sources and the nearest of the targets in the workspace.
+    real_t lower_bound(const SearchWorkspace& workspace) const {
+        real_t bound = REAL_T_MAX;
+        for (auto s : workspace.sources()) {
+            for (auto target : workspace.targets()) {
+                real_t s_bound = lower_bound(s.first, target);
+                if (s_bound != REAL_T_MAX) bound = std::min(bound, s.second + s_bound);
+            }
+        }
+        return bound;
+    }
+
+    // Compute the shortest distance between the sources and the nearest of the targets in the workspace, or max_distance if there is
+    // none closer, with an A* search. The sources must be at integer distances. The search is bounded by the upper bound from the
+    // landmarks, which is the distance if no shorter path is found.
+    real_t distance(const Graph& graph, SearchWorkspace& workspace, real_t max_distance = REAL_T_MAX) const {
+        workspace.reserve(graph.size());
+        auto& forward = workspace.m_forward;
+        auto& heuristic = workspace.m_backward; // Lower bounds to the targets, computed when a node is first touched.
+        heuristic.reserve(graph.size());
+        real_t* dist = forward.dist.data();
+        real_t* h = heuristic.dist.data();
+        auto& is_target = workspace.m_is_target;
+        const auto& targets = workspace.targets();
+        for (auto target : targets) is_target[target] = true;
+
+        auto lower_bound_to_targets = [this, &targets](int_t v) {
+            real_t bound = REAL_T_MAX;
+            for (auto target : targets) bound = std::min(bound, lower_bound(v, target));
+            return bound;
+        };
+
+        real_t bound = max_distance;
+        for (auto s : workspace.sources()) {
+            for (auto target : targets) bound = std::min(bound, s.second + upper_bound(s.first, target));
+        }
+
+        auto& queue = forward.radix_heap;
+        for (auto s : workspace.sources()) {
+            if (h[s.first] == REAL_T_MAX) heuristic.set_distance(s.first, lower_bound_to_targets(s.first));
+            if (s.second + h[s.first] >= bound || s.second >= dist[s.first]) continue;
+            forward.set_distance(s.first, s.second);
+            queue.push((uint64_t) (s.second + h[s.first]), s.first);
+        }
+
+        // The lower bounds are consistent, so the keys never decrease and the first target popped is the nearest.
+        real_t res = bound < max_distance ? bound : max_distance;
+        while (!queue.empty()) {
+            uint64_t key;
+            int_t v;
+            std::tie(key, v) = queue.pop();
+            if (key > dist[v] + h[v]) continue; // Stale entry.
+            if (is_target[v]) {
+                res = dist[v];
+                break;
+            }
+            graph.for_each_neighbor(v, [&](int_t w, real_t weight) {
+                real_t w_distance = dist[v] + weight;
+                if (w_distance >= (dist[w] == REAL_T_MAX ? bound : dist[w])) return;
+                if (h[w] == REAL_T_MAX) heuristic.set_distance(w, lower_bound_to_targets(w));
+                if (w_distance + h[w] >= bound) return; // Any path to a target through w is too long.
+                forward.set_distance(w, w_distance);
+                queue.push((uint64_t) (w_distance + h[w]), w);
+            });
+        }
+        heuristic.reset();
+        workspace.reset();
+        return res;
+    }
+
+private:
+    // Unreachable nodes in the tables.
+    static const uint32_t INF = UINT32_MAX;
+
+    std::size_t m_n_nodes;
+    std::vector<int_t> m_landmarks;
+
+    // Distances from the landmarks to node v are m_table[v * size()], ..., m_table[v * size() + size() - 1].
+    std::vector<uint32_t> m_table;
+
+    const uint32_t* row(int_t v) const { return m_table.data() + v * size(); }
+
+    // Each landmark is the node farthest from the previous ones, starting from the node farthest from the node of highest degree.
+    bool select_farthest(const Graph& graph, std::size_t n_landmarks) {
+        SearchWorkspace workspace;
+        std::vector<real_t> dist, min_dist(m_n_nodes, REAL_T_MAX);
+        graph_distances(graph, highest_degree_nodes(graph, 1).front(), workspace, dist);
+        int_t landmark = std::max_element(dist.begin(), dist.end(), finite_less) - dist.begin();
+        while (m_landmarks.size() < n_landmarks) {
+            graph_distances(graph, landmark, workspace, dist);
+            if (!set_table_column(m_landmarks.size(), n_landmarks, dist)) return false;
+            m_landmarks.push_back(landmark);
+            for (std::size_t v = 0; v < m_n_nodes; ++v) min_dist[v] = std::min(min_dist[v], dist[v]);
+            landmark = std::max_element(min_dist.begin(), min_dist.end(), finite_less) - min_dist.begin();
+            if (min_dist[landmark] == 0.0 || min_dist[landmark] == REAL_T_MAX) break; // All reachable nodes are landmarks.
+        }
+        return true;
+    }
+
+    // The nodes of highest degree, and only one side of each two-sided node. The searches from each landmark run in parallel.
+    bool select_highest_degree(const Graph& graph, std::size_t n_landmarks, int_t n_threads) {
+        m_landmarks = highest_degree_nodes(graph, n_landmarks);
+        bool ok = true;
+        for (std::size_t round_start = 0; round_start < m_landmarks.size(); round_start += n_threads) {
+            std::size_t round_end = std::min(round_start + n_threads, m_landmarks.size());
+            std::vector<std::vector<real_t>> dists(round_end - round_start);
+            std::vector<std::thread> threads;
+            for (std::size_t i = round_start; i < round_end; ++i) {
+                threads.emplace_back([this, &graph, &dists, i, round_start]() {
+                    SearchWorkspace workspace;
+                    graph_distances(graph, m_landmarks[i], workspace, dists[i - round_start]);
+                });
+            }
+            for (auto& thr : threads) thr.join();
+            for (std::size_t i = round_start; i < round_end; ++i) ok = set_table_column(i, n_landmarks, dists[i - round_start]) && ok;
+        }
+        return ok;
+    }
+
+    static std::vector<int_t> highest_degree_nodes(const Graph& graph, std::size_t n_nodes) {
+        std::vector<int_t> nodes;
+        for (std::size_t v = 0; v < graph.size(); ++v) {
+            if (!graph.two_sided() || graph.degree(v) > graph.degree(graph.other_side(v)) || (graph.degree(v) == graph.degree(graph.other_side(v)) && v % 2 == 0)) nodes.push_back(v);
+        }
+        n_nodes = std::min(n_nodes, nodes.size());
+        std::partial_sort(nodes.begin(), nodes.begin() + n_nodes, nodes.end(), [&graph](int_t a, int_t b) {
+            return std::make_pair(-graph.degree(a), a) < std::make_pair(-graph.degree(b), b);
+        });
+        nodes.resize(n_nodes);
+        return nodes;
+    }
+
+    static void graph_distances(const Graph& graph, int_t source, SearchWorkspace& workspace, std::vector<real_t>& dist) {
+        workspace.sources().assign(1, std::make_pair(source, 0.0));
+        graph.distances(workspace, dist);
+    }
+
+    // Compare distances so that unreachable nodes come first.
+    static bool finite_less(real_t a, real_t b) { return a == REAL_T_MAX || (b != REAL_T_MAX && a < b); }
+
+    // Write the distances from landmark i to the tables. Returns false if a distance doesn't fit.
+    bool set_table_column(std::size_t i, std::size_t n_landmarks, const std::vector<real_t>& dist) {
+        for (std::size_t v = 0; v < m_n_nodes; ++v) {
+            if (dist[v] == REAL_T_MAX) continue;
+            if (dist[v] >= INF) return false;
+            m_table[v * n_landmarks + i] = dist[v];
+        }
+        return true;
+    }
+
+};
@@ -0,0 +1,81 @@
+/*
+    Reader for the single container file of single genome graph edges written by gfa1_parser with '-p'.
+    The file is opened once and each genome's edges block is read by its offset.
+
+    Container file layout (integers are 64-bit little-endian):
+        magic "GFA1SGG\0", n_blocks, index_offset,
+        the blocks back to back,
+        the index at index_offset: n_blocks entries of offset, size, name_length and name_length bytes of name.
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+class PackedSggs {
+public:
+    // Check the magic to tell a container from a file listing edge file paths.
+    static bool is_packed(const std::string& filename) {
+        char magic[MAGIC_SIZE];
+        std::ifstream ifs(filename, std::ios::binary);
+        return ifs.read(magic, MAGIC_SIZE) && std::memcmp(magic, MAGIC, MAGIC_SIZE) == 0;
+    }
+
+    // Read the index. Returns false if the file isn't a valid container, e.g. if it's truncated.
+    bool open(const std::string& filename) {
+        m_ifs.open(filename, std::ios::binary | std::ios::ate);
+        uint64_t file_size = m_ifs.tellg();
+        m_ifs.seekg(0);
+        char magic[MAGIC_SIZE];
+        if (!m_ifs.read(magic, MAGIC_SIZE) || std::memcmp(magic, MAGIC, MAGIC_SIZE) != 0) return false;
+        uint64_t n_blocks = read_uint64(), index_offset = read_uint64();
+        // The blocks lie between the header and the index, and each index entry takes at least three integers.
+        if (!m_ifs || index_offset < HEADER_SIZE || index_offset > file_size || n_blocks > (file_size - index_offset) / (3 * 8)) return false;
+        if (!m_ifs.seekg(index_offset)) return false;
+        for (uint64_t idx = 0; idx < n_blocks; ++idx) {
+            uint64_t offset = read_uint64(), size = read_uint64(), name_size = read_uint64();
+            if (!m_ifs || offset < HEADER_SIZE || offset > index_offset || size > index_offset - offset) return false;
+            if (name_size > file_size - (uint64_t) m_ifs.tellg()) return false;
+            std::string name(name_size, '\0');
+            if (!m_ifs.read(&name[0], name.size())) return false;
+            m_offsets.push_back(offset);
+            m_sizes.push_back(size);
+            m_names.push_back(std::move(name));
+        }
+        return true;
+    }
+
+    std::size_t size() const { return m_names.size(); }
+
+    const std::string& name(std::size_t idx) const { return m_names[idx]; }
+
+    // Read the edges block of a genome. Not thread-safe.
+    bool read(std::size_t idx, std::string& block) {
+        block.resize(m_sizes[idx]);
+        return m_ifs.seekg(m_offsets[idx]) && m_ifs.read(&block[0], block.size());
+    }
+
+private:
+    // The string literal includes the terminating '\0'.
+    static constexpr const char* MAGIC = "GFA1SGG";
+    static constexpr std::size_t MAGIC_SIZE = 8;
+    static constexpr uint64_t HEADER_SIZE = MAGIC_SIZE + 2 * 8;
+
+    std::ifstream m_ifs;
+
+    std::vector<std::string> m_names;
+    std::vector<uint64_t> m_offsets;
+    std::vector<uint64_t> m_sizes;
+
+    uint64_t read_uint64() {
+        unsigned char bytes[8] = {};
+        m_ifs.read(reinterpret_cast<char*>(bytes), 8);
+        uint64_t value = 0;
+        for (int i = 7; i >= 0; --i) value = value << 8 | bytes[i];
+        return value;
+    }
+
+};
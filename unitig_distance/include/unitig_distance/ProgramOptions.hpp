@@ -1,12 +1,15 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdint>
 #include <iostream>
 #include <sstream>
 #include <string>
 #include <type_traits>
 #include <vector>
 
+#include "BinaryGraph.hpp"
+#include "MemoryBudget.hpp"
 #include "OperatingMode.hpp"
 #include "types.hpp"
 
@@ -22,7 +25,14 @@ public:
             return;
         }
         set_value(unitigs_filename, "-U", "--unitigs-file");
+        set_value(lengths_filename, "-L", "--lengths-file");
         set_value(edges_filename, "-E", "--edges-file");
+        set_value(gfa1_filename, "-G", "--gfa1-file");
+        set_value(gfa1_out_stem, "-Go", "--gfa1-output-stem");
+        gfa1_sggs = has_arg("-Gs", "--gfa1-sggs");
+        std::string gfa1_max_memory_str;
+        set_value(gfa1_max_memory_str, "-GM", "--gfa1-max-memory");
+        if (!gfa1_max_memory_str.empty() && !MemoryBudget::parse(gfa1_max_memory_str, gfa1_max_memory)) gfa1_max_memory = UINT64_MAX;
         set_value(queries_filename, "-Q", "--queries-file");
         set_value(sggs_filename, "-S", "--sgg-paths-file");
         set_value(out_stem, "-o", "--output-stem");
@@ -30,6 +40,9 @@ public:
         set_value(n_queries, "-n", "--n-queries");
         set_value(queries_format, "-q", "--queries-format");
         set_value(max_distance, "-d", "--max-distance");
+        set_value(ch_filename, "-ch", "--contraction-hierarchy");
+        set_value(n_landmarks, "-A", "--alt-landmarks");
+        set_value(landmark_selection, "-As", "--alt-selection");
         set_value(n_threads, "-t", "--threads");
         set_value(sgg_count_threshold, "-Cc", "--sgg-count-threshold");
         set_value(ld_distance, "-l", "--ld-distance");
@@ -48,10 +61,12 @@ public:
         output_outliers = has_arg("-x", "--output-outliers");
         verbose = has_arg("-v", "--verbose");
 
+        binary_graph = !edges_filename.empty() && BinaryGraph::is_binary(edges_filename);
+
         set_operating_mode();
 
         if (n_queries < 0) n_queries = INT_T_MAX;
-        if (sggs_filename.empty()) sgg_count_threshold = 0;
+        if (sggs_filename.empty() && !gfa1_sggs) sgg_count_threshold = 0;
 
         valid_state = all_required_arguments_provided();
     }
@@ -64,21 +79,29 @@ public:
     static std::string out_sgg_outliers_filename() { return out_stem + ".ud_sgg_outliers" + based_str(); }
     static std::string out_outlier_stats_filename() { return out_stem + ".ud_outlier_stats"; }
     static std::string out_sgg_outlier_stats_filename() { return out_stem + ".ud_sgg_outlier_stats"; }
+    static std::string gfa1_tmp_directory() { return out_stem + "_tmp"; }
 
     // Print details about this run.
     static void print_run_details() {
         std::vector<std::string> arguments;
 
         if (!edges_filename.empty()) {
-            double_push_back(arguments, "  --edges-file", edges_filename);
-            double_push_back(arguments, "  --graphs-one-based", graphs_one_based ? "TRUE" : "FALSE");
+            double_push_back(arguments, "  --edges-file", edges_filename + (binary_graph ? " (binary)" : ""));
+            double_push_back(arguments, "  --graphs-one-based", graphs_one_based && !binary_graph ? "TRUE" : "FALSE");
+        }
+        if (!gfa1_filename.empty()) {
+            double_push_back(arguments, "  --gfa1-file", gfa1_filename);
+            double_push_back(arguments, "  --gfa1-sggs", gfa1_sggs ? "TRUE" : "FALSE");
+            if (!gfa1_out_stem.empty()) double_push_back(arguments, "  --gfa1-output-stem", gfa1_out_stem);
+            if (gfa1_max_memory > 0) double_push_back(arguments, "  --gfa1-max-memory", std::to_string(gfa1_max_memory));
         }
         if (has_operating_mode(OperatingMode::CDBG)) {
-            double_push_back(arguments, "  --unitigs-file", unitigs_filename);
+            if (!unitigs_filename.empty()) double_push_back(arguments, "  --unitigs-file", unitigs_filename);
+            else if (!lengths_filename.empty()) double_push_back(arguments, "  --lengths-file", lengths_filename);
             double_push_back(arguments, "  --k-mer-length", std::to_string(k));
         }
         if (has_operating_mode(OperatingMode::SGGS)) {
-            double_push_back(arguments, "  --sgg-paths-file", sggs_filename);
+            if (gfa1_filename.empty()) double_push_back(arguments, "  --sgg-paths-file", sggs_filename);
             double_push_back(arguments, "  --run-sggs-only", run_sggs_only ? "TRUE" : "FALSE");
         }
         double_push_back(arguments, "  --queries-file", queries_filename);
@@ -86,6 +109,11 @@ public:
         double_push_back(arguments, "  --n-queries", n_queries == INT_T_MAX ? "ALL" : std::to_string(n_queries));
         double_push_back(arguments, "  --queries-format", queries_format < 0 ? "AUTOM" : std::to_string(queries_format));
         double_push_back(arguments, "  --max-distance", max_distance == REAL_T_MAX ? "INF" : std::to_string(max_distance));
+        if (!ch_filename.empty()) double_push_back(arguments, "  --contraction-hierarchy", ch_filename);
+        if (n_landmarks > 0) {
+            double_push_back(arguments, "  --alt-landmarks", std::to_string(n_landmarks));
+            double_push_back(arguments, "  --alt-selection", landmark_selection);
+        }
         if (has_operating_mode(OperatingMode::OUTLIER_TOOLS)) {
             double_push_back(arguments, "  --output-outliers", output_outliers ? "TRUE" : "FALSE");
             double_push_back(arguments, "  --sgg-count-threshold", std::to_string(sgg_count_threshold));
@@ -110,13 +138,19 @@ public:
     }
 
     static std::string unitigs_filename;
+    static std::string lengths_filename;
     static std::string edges_filename;
+    static std::string gfa1_filename;
+    static std::string gfa1_out_stem;
     static std::string queries_filename;
     static std::string sggs_filename;
     static std::string out_stem;
+    static std::string ch_filename;
+    static std::string landmark_selection;
     static int_t k;
     static int_t n_queries;
     static int_t queries_format;
+    static int_t n_landmarks;
     static real_t max_distance;
     static int_t n_threads;
     static int_t sgg_count_threshold;
@@ -131,6 +165,9 @@ public:
     static bool run_sggs_only;
     static bool output_outliers;
     static bool verbose;
+    static bool binary_graph;
+    static bool gfa1_sggs;
+    static uint64_t gfa1_max_memory;
     static bool valid_state;
     static OperatingMode operating_mode;
 
@@ -140,8 +177,12 @@ private:
 
     static void set_operating_mode() {
         if (output_outliers) operating_mode |= OperatingMode::OUTLIER_TOOLS;
-        if (!edges_filename.empty()) {
-            if (unitigs_filename.empty()) {
+        if (!gfa1_filename.empty()) {
+            // The graphs are constructed in-process from the GFA1 file.
+            operating_mode |= OperatingMode::CDBG;
+            if (gfa1_sggs) operating_mode |= OperatingMode::SGGS;
+        } else if (!edges_filename.empty()) {
+            if (unitigs_filename.empty() && lengths_filename.empty() && !binary_graph) {
                 operating_mode |= OperatingMode::GENERAL;
             } else {
                 operating_mode |= OperatingMode::CDBG;
@@ -161,9 +202,20 @@ private:
             std::cerr << "Error: Queries format must be less than 6.\n";
             ok = false;
         }
+        if (gfa1_max_memory == UINT64_MAX) {
+            std::cerr << "Error: GFA1 memory budget must be given as bytes or with a suffix K, M, G or T, e.g. 64G.\n";
+            ok = false;
+        } else if (gfa1_max_memory > 0 && gfa1_max_memory < MemoryBudget::MIN_MEMORY) {
+            std::cerr << "Error: GFA1 memory budget must be at least " << (MemoryBudget::MIN_MEMORY >> 20) << "M.\n";
+            ok = false;
+        }
+        if (landmark_selection != "farthest" && landmark_selection != "degree") {
+            std::cerr << "Error: Landmark selection must be 'farthest' or 'degree'.\n";
+            ok = false;
+        }
         // Normal operating modes.
         if (operating_mode != OperatingMode::OUTLIER_TOOLS) {
-            if (edges_filename.empty()) {
+            if (edges_filename.empty() && gfa1_filename.empty()) {
                 std::cerr << "Error: Missing edges filename.\n";
                 ok = false;
             }
@@ -205,15 +257,22 @@ private:
     static void print_help() {
         std::vector<std::string> options{
             "Graph edges:", "",
-            "  -E  [ --edges-file ] arg", "Path to file containing graph edges.",
+            "  -E  [ --edges-file ] arg", "Path to file containing graph edges, or a binary graph (CDBG mode).",
             "  -1g [ --graphs-one-based ]", "Graph files use one-based numbering.",
             "", "",
             "CDBG operating mode:", "",
             "  -U  [ --unitigs-file ] arg", "Path to file containing unitigs.",
+            "  -L  [ --lengths-file ] arg", "Path to file containing unitig lengths (instead of unitigs).",
             "  -k  [ --k-mer-length ] arg", "k-mer length.",
             "", "",
+            "In-process GFA1 input (instead of the graph files):", "",
+            "  -G  [ --gfa1-file ] arg", "Path to a GFA1 file to construct the graphs from in-process.",
+            "  -Gs [ --gfa1-sggs ]", "Also construct the single genome graphs from the GFA1 path lines.",
+            "  -Go [ --gfa1-output-stem ] arg", "Also write gfa1_parser's output files with this stem.",
+            "  -GM [ --gfa1-max-memory ] arg", "Keep parsing the GFA1 file within about arg bytes (e.g. 64G, at least 8M), spilling to disk.",
+            "", "",
             "CDBG and/or SGGS operating mode:", "",
-            "  -S  [ --sgg-paths-file ] arg", "Path to file containing paths to single genome graph edge files.",
+            "  -S  [ --sgg-paths-file ] arg", "Path to file containing paths to single genome graph edge files, or a packed file.",
             "  -r  [ --run-sggs-only ]", "Calculate distances only in the single genome graphs.",
             "", "",
             "Distance queries:", "",
@@ -222,6 +281,9 @@ private:
             "  -n  [ --n-queries ] arg (=inf)", "Number of queries to read from the queries file.",
             "  -q  [ --queries-format ] arg (-1)", "Set queries format manually (0..5).",
             "  -d  [ --max-distance ] arg (=inf)", "Maximum allowed graph distance (for constraining the searches).",
+            "  -ch [ --contraction-hierarchy ] arg", "Path to a contraction hierarchy of the main graph, built and saved if the file doesn't exist.",
+            "  -A  [ --alt-landmarks ] arg (=0)", "Number of landmarks for bounding and guiding the main graph searches.",
+            "  -As [ --alt-selection ] arg (=farthest)", "Landmark selection, 'farthest' or 'degree'.",
             "", "",
             "Tools for determining outliers:", "",
             "  -x  [ --output-outliers ]", "Output a list of outliers and outlier statistics.",
@@ -0,0 +1,72 @@
+/*
+    Monotone priority queue of (key, value) pairs with integer keys, for Dijkstra's algorithm on graphs with integer weights.
+    Pushed keys must not be smaller than the last popped key. An entry is kept in the bucket given by the highest bit in which
+    its key differs from the last popped key, so each entry is moved O(log C) times for keys up to C.
+    There is no decrease-key, a smaller key for the same value is pushed as a new entry and the old one is skipped when popped.
+*/
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "types.hpp"
+
+class RadixHeap {
+public:
+    using key_type = uint64_t;
+
+    RadixHeap() : m_last(0), m_size(0) { }
+
+    bool empty() const { return m_size == 0; }
+
+    std::size_t size() const { return m_size; }
+
+    void push(uint64_t key, int_t value) {
+        m_buckets[bucket_idx(key)].emplace_back(key, value);
+        ++m_size;
+    }
+
+    // Return the smallest key without removing its entry.
+    uint64_t top_key() {
+        if (m_buckets[0].empty()) redistribute();
+        return m_last;
+    }
+
+    // Remove and return an entry with the smallest key.
+    std::pair<uint64_t, int_t> pop() {
+        if (m_buckets[0].empty()) redistribute();
+        auto entry = m_buckets[0].back();
+        m_buckets[0].pop_back();
+        --m_size;
+        return entry;
+    }
+
+    // Empty the queue, keeping the memory of the buckets.
+    void clear() {
+        for (auto& bucket : m_buckets) bucket.clear();
+        m_last = 0;
+        m_size = 0;
+    }
+
+private:
+    enum { N_BUCKETS = 65 };
+
+    std::vector<std::pair<uint64_t, int_t>> m_buckets[N_BUCKETS];
+    uint64_t m_last;
+    std::size_t m_size;
+
+    std::size_t bucket_idx(uint64_t key) const { return key == m_last ? 0 : 64 - __builtin_clzll(key ^ m_last); }
+
+    // Redistribute the first non-empty bucket around its smallest key. Its entries move to lower buckets.
+    void redistribute() {
+        std::size_t idx = 1;
+        while (m_buckets[idx].empty()) ++idx;
+        auto& bucket = m_buckets[idx];
+        m_last = std::min_element(bucket.begin(), bucket.end())->first;
+        for (const auto& entry : bucket) m_buckets[bucket_idx(entry.first)].push_back(entry);
+        bucket.clear();
+    }
+
+};
@@ -1,9 +1,9 @@
 #pragma once
 
-#include <fstream>
 #include <numeric>
 
 #include "DistanceVector.hpp"
+#include "OutputBuffer.hpp"
 #include "ProgramOptions.hpp"
 #include "Queries.hpp"
 #include "Utils.hpp"
@@ -17,8 +17,9 @@ public:
     }
 
     static void output_results(const std::string& out_filename, const Queries& queries, const DistanceVector& dv, const std::vector<int_t>& indices) {
-        std::ofstream ofs(out_filename);
-        
+        OutputBuffer out;
+        if (!out.open(out_filename, true)) return;
+
         bool write_counts = dv.storing_mean_distances();
 
         int_t queries_format = queries.queries_format();
@@ -28,15 +29,15 @@ public:
         std::tie(distance_field, flag_field, score_field, count_field) = Utils::get_field_indices(queries_format);
 
         for (auto idx : indices) {
-            ofs << queries.v(idx) + ProgramOptions::output_one_based << ' ' << queries.w(idx) + ProgramOptions::output_one_based;
-            ofs << ' ' << (int_t) Utils::fixed_distance(dv[idx].distance(), ProgramOptions::max_distance);
-            if (flag_field) ofs << ' ' << queries.flag(idx);
-            if (score_field) ofs << ' ' << queries.score(idx);
-            if (write_counts) ofs << ' ' << dv[idx].count();
-            ofs << ' ' << dv[idx].m2();
-            ofs << ' ' << dv[idx].min();
-            ofs << ' ' << dv[idx].max();
-            ofs << '\n';
+            out << queries.v(idx) + ProgramOptions::output_one_based << ' ' << queries.w(idx) + ProgramOptions::output_one_based;
+            out << ' ' << (int_t) Utils::fixed_distance(dv[idx].distance(), ProgramOptions::max_distance);
+            if (flag_field) out << ' ' << queries.flag(idx);
+            if (score_field) out << ' ' << queries.score(idx);
+            if (write_counts) out << ' ' << dv[idx].count();
+            out << ' ' << dv[idx].m2();
+            out << ' ' << dv[idx].min();
+            out << ' ' << dv[idx].max();
+            out << '\n';
         }
     }
 
@@ -0,0 +1,87 @@
+/*
+    Memory reused by the graph searches of one thread. The distance and target arrays grow to the largest graph searched and are
+    kept between searches. A search records the nodes it touches and resets only those, so that its cost depends on the part of
+    the graph it explores rather than on the size of the graph. The sources and targets of a search are given in the workspace's
+    vectors and the distances to the targets are returned in target_dist(). Bidirectional searches also use a second search state
+    for the search from the targets, which is allocated by the first of them.
+*/
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "DaryHeap.hpp"
+#include "RadixHeap.hpp"
+#include "types.hpp"
+
+class SearchWorkspace {
+public:
+    SearchWorkspace() = default;
+    SearchWorkspace(const SearchWorkspace& other) = delete;
+    SearchWorkspace(SearchWorkspace&& other) = default;
+    SearchWorkspace& operator=(const SearchWorkspace& other) = delete;
+
+    // (node, initial distance) pairs.
+    std::vector<std::pair<int_t, real_t>>& sources() { return m_sources; }
+    const std::vector<std::pair<int_t, real_t>>& sources() const { return m_sources; }
+
+    std::vector<int_t>& targets() { return m_targets; }
+    const std::vector<int_t>& targets() const { return m_targets; }
+
+    // Distances to targets() after Graph::distance(), max_distance for targets that weren't reached.
+    const std::vector<real_t>& target_dist() const { return m_target_dist; }
+
+private:
+    friend class ContractionHierarchy;
+    friend class Graph;
+    friend class Landmarks;
+
+    std::vector<std::pair<int_t, real_t>> m_sources;
+    std::vector<int_t> m_targets;
+    std::vector<real_t> m_target_dist;
+
+    // Distances and queues of a search in one direction. Untouched nodes have distance REAL_T_MAX.
+    struct SearchState {
+        std::vector<real_t> dist;
+        std::vector<int_t> touched;
+        RadixHeap radix_heap;
+        DaryHeap dary_heap;
+
+        void reserve(std::size_t n_nodes) {
+            if (dist.size() < n_nodes) dist.resize(n_nodes, REAL_T_MAX);
+        }
+
+        void set_distance(int_t v, real_t distance) {
+            if (dist[v] == REAL_T_MAX) touched.push_back(v);
+            dist[v] = distance;
+        }
+
+        void reset() {
+            // Writing the whole array sequentially is faster than scattered writes when a large part of it was touched.
+            if (touched.size() > dist.size() / 16) std::fill(dist.begin(), dist.end(), REAL_T_MAX);
+            else for (auto v : touched) dist[v] = REAL_T_MAX;
+            touched.clear();
+            radix_heap.clear();
+            dary_heap.clear();
+        }
+    };
+
+    SearchState m_forward;
+    SearchState m_backward; // Only used by bidirectional searches.
+    std::vector<bool> m_is_target;
+    std::vector<uint8_t> m_hops; // Edges on the paths of contraction hierarchy witness searches.
+
+    void reserve(std::size_t n_nodes) {
+        m_forward.reserve(n_nodes);
+        if (m_is_target.size() < n_nodes) m_is_target.resize(n_nodes);
+    }
+
+    // Reset the touched nodes and the targets for the next search.
+    void reset() {
+        m_forward.reset();
+        for (auto w : m_targets) m_is_target[w] = false;
+    }
+
+};
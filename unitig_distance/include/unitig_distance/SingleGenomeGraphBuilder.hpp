@@ -1,7 +1,12 @@
 #pragma once
 
+#include <iostream>
+#include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "BinaryGraph.hpp"
 #include "GraphBuilder.hpp"
 #include "SingleGenomeGraph.hpp"
 #include "types.hpp"
@@ -10,9 +15,31 @@ class SingleGenomeGraphBuilder {
 public:
     // Construct a compressed single genome graph, which is an edge-induced subgraph from the compacted de Bruijn graph.
     static SingleGenomeGraph build_sgg(const Graph& cdbg, const std::string& edges_filename) {
-        SingleGenomeGraph sgg;
+        return compress_subgraph(GraphBuilder::build_cdbg_subgraph(cdbg, edges_filename));
+    }
+
+    // Same as above, but the edges are given by a block of a packed single genome graphs file, either as text or as a binary graph.
+    static SingleGenomeGraph build_sgg_from_block(const Graph& cdbg, const std::string& block, const std::string& name) {
+        if (BinaryGraph::is_binary(block.data(), block.size())) {
+            BinaryGraph binary_graph;
+            if (!binary_graph.view(block.data(), block.size())) {
+                std::cerr << "Error: Invalid binary graph for single genome graph " << name << std::endl;
+                return SingleGenomeGraph();
+            }
+            return compress_subgraph(GraphBuilder::build_cdbg_subgraph(cdbg, binary_graph));
+        }
+        std::istringstream edges(block);
+        return compress_subgraph(GraphBuilder::build_cdbg_subgraph(cdbg, edges, name));
+    }
 
-        Graph subgraph = GraphBuilder::build_cdbg_subgraph(cdbg, edges_filename);
+    // Same as above, but the edges are given as (v, w) pairs of node sides, e.g. straight from an in-process parser.
+    static SingleGenomeGraph build_sgg(const Graph& cdbg, const std::vector<std::pair<int_t, int_t>>& edges) {
+        return compress_subgraph(GraphBuilder::build_cdbg_subgraph(cdbg, edges));
+    }
+
+private:
+    static SingleGenomeGraph compress_subgraph(const Graph& subgraph) {
+        SingleGenomeGraph sgg;
 
         if (subgraph.size() == 0) return SingleGenomeGraph();
 
@@ -48,10 +75,10 @@ public:
             }
         }
 
+        if (!sgg.finalize()) return SingleGenomeGraph();
         return sgg;
     }
 
-private:
     // Functions used by the builder's DFS search.
     static void dfs_add_neighbors_to_stack(
         const Graph& subgraph,
@@ -59,11 +86,9 @@ private:
         std::vector<std::tuple<int_t, int_t, real_t>>& stack,
         int_t original_idx)
     {
-        for (auto neighbor : subgraph[original_idx]) {
-            auto neighbor_idx = neighbor.first;
-            auto weight = neighbor.second;
+        subgraph.for_each_neighbor(original_idx, [&stack, original_idx](int_t neighbor_idx, real_t weight) {
             stack.emplace_back(original_idx, neighbor_idx, weight);
-        }
+        });
     }
 
     static void add_and_map_node(SingleGenomeGraph& sgg, int_t original_idx) { sgg.map_node(original_idx, INT_T_MAX, sgg.size()); sgg.add_node(); } // Add non-path node.
@@ -76,10 +101,10 @@ private:
 
         // Move along the path.
         while (subgraph.degree(w) == 2) {
-            auto it = subgraph[w].begin();
-            if (it->first == prev_node) ++it;
+            int_t idx = subgraph.neighbor(w, 0) == prev_node;
             prev_node = w;
-            std::tie(w, weight) = *it;
+            weight = subgraph.weight(w, idx);
+            w = subgraph.neighbor(w, idx);
             nodes_in_path.push_back(w);
             weight += D.back(); // Accumulate weight.
             D.push_back(weight);
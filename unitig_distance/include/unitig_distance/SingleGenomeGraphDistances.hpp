@@ -1,8 +1,8 @@
 #pragma once
 
+#include <algorithm>
+#include <functional>
 #include <iostream>
-#include <map>
-#include <set>
 #include <thread>
 #include <unordered_map>
 #include <utility>
@@ -12,16 +12,29 @@
 #include "DistanceVector.hpp"
 #include "ProgramOptions.hpp"
 #include "SearchJobs.hpp"
+#include "SearchWorkspace.hpp"
 #include "SingleGenomeGraph.hpp"
 #include "Timer.hpp"
 #include "types.hpp"
 
+// Calculate mean distances in the single genome graphs given with '-S'.
 DistanceVector calculate_sgg_distances(const Graph& graph, const SearchJobs& search_jobs, Timer& timer);
 
+// Constructs the single genome graphs i, ..., i + sg_graphs.size() - 1 into sg_graphs. Called with consecutive batches.
+using sgg_batch_builder_t = std::function<bool(std::size_t i, std::vector<SingleGenomeGraph>& sg_graphs)>;
+
+// Calculate mean distances in n_sggs single genome graphs constructed in batches by build_batch.
+DistanceVector calculate_sgg_distances(const SearchJobs& search_jobs, Timer& timer, std::size_t n_sggs, const sgg_batch_builder_t& build_batch);
+
 class SingleGenomeGraphDistances {
 public:
     SingleGenomeGraphDistances() = delete;
-    SingleGenomeGraphDistances(const SingleGenomeGraph& graph) : m_graph(graph), m_max_distance(ProgramOptions::max_distance) { }
+    // The workspaces, one per thread, are reused across the single genome graphs.
+    SingleGenomeGraphDistances(const SingleGenomeGraph& graph, std::vector<SearchWorkspace>& workspaces)
+    : m_graph(graph),
+      m_workspaces(workspaces),
+      m_max_distance(ProgramOptions::max_distance)
+    { }
 
     // Calculate distances for single genome graphs.
     std::vector<std::unordered_map<int_t, Distance>> solve(const SearchJobs& search_jobs) {
@@ -29,6 +42,8 @@ public:
         std::vector<std::unordered_map<int_t, Distance>> sgg_batch_distances(n_threads);
         auto calculate_distance_block = [this, &search_jobs, &sgg_batch_distances, n_threads](std::size_t thr) {
             const auto& graph = m_graph;
+            auto& workspace = m_workspaces[thr];
+            std::vector<real_t> job_dist;
             for (std::size_t i = thr; i < search_jobs.size(); i += n_threads) {
                 const auto& job = search_jobs[i];
 
@@ -36,18 +51,14 @@ public:
                 if (!graph.contains_original(v)) continue;
 
                 // First calculate distances between path start/end nodes.
-                auto sources = get_sgg_sources(v);
-                auto targets = get_sgg_targets(job.ws());
-                auto target_dist = graph.distance(sources, targets, m_max_distance);
-
-                // Map results.
-                std::map<int_t, real_t> dist;
-                for (std::size_t j = 0; j < targets.size(); ++j) dist[targets[j]] = target_dist[j];
+                set_sgg_sources(workspace, v);
+                set_sgg_targets(workspace, job.ws());
+                graph.distance(workspace, m_max_distance);
 
                 // Now fix distances for (v, w) that were in paths.
-                std::vector<real_t> job_dist(job.ws().size(), m_max_distance);
-                process_job_distances(job_dist, graph.left_node(v), job.ws(), dist);
-                process_job_distances(job_dist, graph.right_node(v), job.ws(), dist);
+                job_dist.assign(job.ws().size(), m_max_distance);
+                process_job_distances(job_dist, graph.left_node(v), job.ws(), workspace);
+                process_job_distances(job_dist, graph.right_node(v), job.ws(), workspace);
 
                 add_job_distances_to_sgg_distances(sgg_batch_distances[thr], job, job_dist);
             }
@@ -60,6 +71,7 @@ public:
 
 private:
     const SingleGenomeGraph& m_graph;
+    std::vector<SearchWorkspace>& m_workspaces;
 
     real_t m_max_distance;
 
@@ -72,8 +84,9 @@ private:
     }
 
     // Add both sides of v as sources.
-    std::vector<std::pair<int_t, real_t>> get_sgg_sources(int_t v) {
-        std::vector<std::pair<int_t, real_t>> sources;
+    void set_sgg_sources(SearchWorkspace& workspace, int_t v) {
+        auto& sources = workspace.sources();
+        sources.clear();
         for (int_t v_original_idx = m_graph.left_node(v); v_original_idx <= m_graph.right_node(v); ++v_original_idx) {
             auto v_mapped_idx = m_graph.mapped_idx(v_original_idx);
             // Add v normally if it's not on a path, otherwise add both path end points.
@@ -91,55 +104,60 @@ private:
                 add_source(sources, v_mapped_idx, 0.0);
             }
         }
-        return sources;
     }
 
-    // Add both sides of each w as targets.
-    std::vector<int_t> get_sgg_targets(const std::vector<int_t>& ws) {
-        std::set<int_t> target_set;
+    // Add both sides of each w as targets, sorted and without duplicates.
+    void set_sgg_targets(SearchWorkspace& workspace, const std::vector<int_t>& ws) {
+        auto& targets = workspace.targets();
+        targets.clear();
         for (auto w : ws) {
             if (!m_graph.contains_original(w)) continue;
             for (int_t w_original_idx = m_graph.left_node(w); w_original_idx <= m_graph.right_node(w); ++w_original_idx) {
                 if (m_graph.is_on_path(w_original_idx)) {
                     auto w_path_idx = m_graph.path_idx(w_original_idx);
-                    target_set.insert(m_graph.start_node(w_path_idx));
-                    target_set.insert(m_graph.end_node(w_path_idx));
+                    targets.push_back(m_graph.start_node(w_path_idx));
+                    targets.push_back(m_graph.end_node(w_path_idx));
                 } else {
-                    target_set.insert(m_graph.mapped_idx(w_original_idx));
+                    targets.push_back(m_graph.mapped_idx(w_original_idx));
                 }
             }
         }
-        std::vector<int_t> targets;
-        for (auto t : target_set) targets.push_back(t);
-        return targets;
+        std::sort(targets.begin(), targets.end());
+        targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+    }
+
+    // Distance from the sources to a target, found by binary search in the sorted targets.
+    real_t target_distance(const SearchWorkspace& workspace, int_t target) {
+        const auto& targets = workspace.targets();
+        return workspace.target_dist()[std::lower_bound(targets.begin(), targets.end(), target) - targets.begin()];
     }
 
     // Correct (v, w) distance if w were on a path.
-    real_t get_correct_distance(int_t v_path_idx, int_t v_mapped_idx, int_t w_original_idx, std::map<int_t, real_t>& dist) {
+    real_t get_correct_distance(int_t v_path_idx, int_t v_mapped_idx, int_t w_original_idx, const SearchWorkspace& workspace) {
         auto w_path_idx = m_graph.path_idx(w_original_idx);
         auto w_mapped_idx = m_graph.mapped_idx(w_original_idx);
-        if (w_path_idx == INT_T_MAX) return dist[w_mapped_idx]; // w not on path, distance from sources is correct already.
+        if (w_path_idx == INT_T_MAX) return target_distance(workspace, w_mapped_idx); // w not on path, distance from sources is correct already.
         // Get distance if v and w are on the same path, this distance could be shorter.
         real_t distance = v_path_idx == w_path_idx ? m_graph.distance_in_path(v_path_idx, v_mapped_idx, w_mapped_idx) : REAL_T_MAX;
         // w on path, add distances of (w, path_endpoint).
         int_t w_path_endpoint;
         real_t w_path_distance;
         std::tie(w_path_endpoint, w_path_distance) = m_graph.distance_to_start(w_path_idx, w_mapped_idx);
-        distance = std::min(distance, dist[w_path_endpoint] + w_path_distance);
+        distance = std::min(distance, target_distance(workspace, w_path_endpoint) + w_path_distance);
         std::tie(w_path_endpoint, w_path_distance) = m_graph.distance_to_end(w_path_idx, w_mapped_idx);
-        distance = std::min(distance, dist[w_path_endpoint] + w_path_distance);
+        distance = std::min(distance, target_distance(workspace, w_path_endpoint) + w_path_distance);
         return distance;
     }
 
     // Fix distances for (v, w) that were in paths.
-    void process_job_distances(std::vector<real_t>& job_dist, int_t v_original_idx, const std::vector<int_t>& ws, std::map<int_t, real_t>& dist) {
+    void process_job_distances(std::vector<real_t>& job_dist, int_t v_original_idx, const std::vector<int_t>& ws, const SearchWorkspace& workspace) {
         auto v_path_idx = m_graph.path_idx(v_original_idx);
         auto v_mapped_idx = m_graph.mapped_idx(v_original_idx);
         for (std::size_t w_idx = 0; w_idx < ws.size(); ++w_idx) { 
             auto w = ws[w_idx];
             if (!m_graph.contains_original(w)) continue;
-            auto distance = get_correct_distance(v_path_idx, v_mapped_idx, m_graph.left_node(w), dist);
-            distance = std::min(distance, get_correct_distance(v_path_idx, v_mapped_idx, m_graph.right_node(w), dist));
+            auto distance = get_correct_distance(v_path_idx, v_mapped_idx, m_graph.left_node(w), workspace);
+            distance = std::min(distance, get_correct_distance(v_path_idx, v_mapped_idx, m_graph.right_node(w), workspace));
             job_dist[w_idx] = std::min(job_dist[w_idx], distance);
         }
     }
@@ -2,9 +2,11 @@
 
 #include <fstream>
 #include <string>
+#include <sys/stat.h>
 #include <tuple>
 #include <vector>
 
+#include "PackedSggs.hpp"
 #include "ProgramOptions.hpp"
 #include "types.hpp"
 
@@ -21,6 +23,11 @@ public:
         return std::ifstream(filename).good();
     }
 
+    static bool file_exists(const std::string& filename) {
+        struct stat st;
+        return stat(filename.c_str(), &st) == 0;
+    }
+
     static std::string neat_number_str(int_t number) {
         std::vector<int_t> parts;
         do parts.push_back(number % 1000);
@@ -49,15 +56,23 @@ public:
     static void clear(T& container) { T().swap(container); }
 
     static bool sanity_check_input_files() {
-        if (ProgramOptions::operating_mode != OperatingMode::OUTLIER_TOOLS) {
+        if (!ProgramOptions::gfa1_filename.empty()) {
+            // The GFA1 file may also be "-" for stdin.
+            if (ProgramOptions::gfa1_filename != "-" && !Utils::file_is_good(ProgramOptions::gfa1_filename)) {
+                std::cerr << "Error: Can't open " << ProgramOptions::gfa1_filename << std::endl;
+                return false;
+            }
+        } else if (ProgramOptions::operating_mode != OperatingMode::OUTLIER_TOOLS) {
             if (!Utils::file_is_good(ProgramOptions::edges_filename)) {
                 std::cerr << "Error: Can't open " << ProgramOptions::edges_filename << std::endl;
                 return false;
             }
 
             if (ProgramOptions::has_operating_mode(OperatingMode::CDBG)) {
-                if (!Utils::file_is_good(ProgramOptions::unitigs_filename)) {
-                    std::cerr << "Error: Can't open " << ProgramOptions::unitigs_filename << std::endl;
+                // A binary graph holds the unitig lengths itself.
+                const std::string& unitigs_filename = ProgramOptions::unitigs_filename.empty() ? ProgramOptions::lengths_filename : ProgramOptions::unitigs_filename;
+                if (!ProgramOptions::binary_graph && !Utils::file_is_good(unitigs_filename)) {
+                    std::cerr << "Error: Can't open " << unitigs_filename << std::endl;
                     return false;
                 }
 
@@ -66,12 +81,20 @@ public:
                         std::cerr << "Error: Can't open " << ProgramOptions::sggs_filename << std::endl;
                         return false;
                     }
-                    std::ifstream ifs(ProgramOptions::sggs_filename);
-                    for (std::string path_edges; std::getline(ifs, path_edges); ) {
-                        if (!Utils::file_is_good(path_edges)) {
-                            std::cerr << "Error: Can't open " << path_edges << std::endl;
+                    if (PackedSggs::is_packed(ProgramOptions::sggs_filename)) {
+                        // Only the index of a packed single genome graphs file is checked, without opening anything per genome.
+                        if (!PackedSggs().open(ProgramOptions::sggs_filename)) {
+                            std::cerr << "Error: Invalid packed single genome graphs file " << ProgramOptions::sggs_filename << std::endl;
                             return false;
                         }
+                    } else {
+                        std::ifstream ifs(ProgramOptions::sggs_filename);
+                        for (std::string path_edges; std::getline(ifs, path_edges); ) {
+                            if (!Utils::file_is_good(path_edges)) {
+                                std::cerr << "Error: Can't open " << path_edges << std::endl;
+                                return false;
+                            }
+                        }
                     }
                 }
             }
@@ -11,3 +11,11 @@ const int_t INT_T_MAX = std::numeric_limits<int_t>::max();
 using real_t = double;
 const real_t REAL_T_MAX = std::numeric_limits<real_t>::max();
 
+// Node ids and edge offsets stored in graphs. Graphs with 2^32 or more nodes or edges need a build with LARGE_GRAPHS defined.
+#ifdef LARGE_GRAPHS
+using index_t = uint64_t;
+#else
+using index_t = uint32_t;
+#endif
+const index_t INDEX_T_MAX = std::numeric_limits<index_t>::max();
+
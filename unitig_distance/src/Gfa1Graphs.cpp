@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gfa1_parser.hpp"
+
+#include "Block.hpp"
+#include "BlockPipeline.hpp"
+#include "Errors.hpp"
+#include "Gfa1Graphs.hpp"
+#include "Graph.hpp"
+#include "InputBuffer.hpp"
+#include "Links.hpp"
+#include "MemoryBudget.hpp"
+#include "Parser.hpp"
+#include "PathData.hpp"
+#include "Paths.hpp"
+#include "Segments.hpp"
+#include "SingleGenomeGraph.hpp"
+#include "SingleGenomeGraphBuilder.hpp"
+#include "types.hpp"
+
+struct Gfa1Graphs::State {
+    Segments segments;
+    Links links;
+    Paths paths;
+    PathData path_data;
+    Errors errors;
+    std::unique_ptr<Parser> parser;
+
+    std::string out_stem;
+    std::string tmp_directory; // Holds the spill files within a memory budget.
+    std::size_t n_finished_paths = 0;
+
+    // Batch of single genome graphs being constructed by the parser's path callback.
+    const Graph* cdbg = nullptr;
+    std::vector<SingleGenomeGraph>* sg_graphs = nullptr;
+    std::size_t batch_begin = 0;
+};
+
+Gfa1Graphs::Gfa1Graphs() : m_state(new State) { }
+
+Gfa1Graphs::~Gfa1Graphs() {
+    State& state = *m_state;
+    if (state.tmp_directory.empty()) return;
+    state.links.clear();
+    state.path_data.remove_spill();
+    std::remove(state.tmp_directory.c_str());
+}
+
+bool Gfa1Graphs::read(const std::string& gfa1_filename, const std::string& out_stem, std::size_t n_threads,
+                      uint64_t max_memory, const std::string& tmp_directory) {
+    State& state = *m_state;
+    state.out_stem = out_stem;
+    const std::string path_directory = out_stem + "_paths";
+
+    if (!out_stem.empty()) {
+        if (!gfa1_parser::directory_exists(path_directory) && gfa1_parser::create_directory(path_directory) != 0) {
+            std::cerr << "Error: Failed to create directory " << path_directory << std::endl;
+            return false;
+        }
+        if (!state.segments.open(out_stem + ".unitigs")) {
+            std::cerr << "Error: Can't open " << out_stem << ".unitigs" << std::endl;
+            return false;
+        }
+    }
+
+    if (max_memory > 0) {
+        if (!gfa1_parser::directory_exists(tmp_directory) && gfa1_parser::create_directory(tmp_directory) != 0) {
+            std::cerr << "Error: Failed to create directory " << tmp_directory << std::endl;
+            return false;
+        }
+        state.tmp_directory = tmp_directory;
+        state.links.set_spill(tmp_directory + "/links", MemoryBudget::links_memory(max_memory));
+        if (!state.path_data.set_spill(tmp_directory + "/path_lines", MemoryBudget::path_lines_memory(max_memory))) {
+            std::cerr << "Error: Can't open " << tmp_directory << "/path_lines" << std::endl;
+            return false;
+        }
+    }
+
+    const std::size_t pipeline_memory = MemoryBudget::pipeline_memory(max_memory);
+    InputBuffer input(BlockPipeline::input_memory(pipeline_memory));
+    if (!input.open(gfa1_filename)) {
+        std::cerr << "Error: Can't open " << gfa1_filename << std::endl;
+        return false;
+    }
+
+    // Paths are finished only after all lines have been read, when the graph can be constructed.
+    state.parser.reset(new Parser(state.segments, state.links, state.paths, state.path_data, state.errors, n_threads));
+    if (max_memory > 0) state.parser->set_max_batch_memory(MemoryBudget::path_lines_memory(max_memory));
+    state.parser->set_path_callback([&state](std::size_t path_idx, const Path& path) {
+        if (state.sg_graphs == nullptr) return true;
+        std::vector<std::pair<int_t, int_t>> edges;
+        path.for_each_link([&edges](uint64_t from_id, uint64_t to_id, uint64_t edge_type, uint64_t overlap) {
+            if (overlap == 0) return; // Non-overlapping edges ignored.
+            int_t v = 2 * from_id + !(edge_type & 2); // F* edge means link comes from v's right side.
+            int_t w = 2 * to_id + (edge_type & 1); // *R edge means link goes to w's right side.
+            edges.emplace_back(v, w);
+        });
+        (*state.sg_graphs)[path_idx - state.batch_begin] = SingleGenomeGraphBuilder::build_sgg(*state.cdbg, edges);
+        return true;
+    });
+
+    bool ok = true;
+    BlockPipeline pipeline(input, state.errors, n_threads, pipeline_memory);
+    pipeline.start();
+    for (Block block; ok && pipeline.next_block(block); ) {
+        ok = block.ok();
+        if (ok) ok = state.parser->process_block(block);
+        input.release(block.end());
+    }
+    pipeline.stop();
+    if (!ok) {
+        state.errors.print_errors();
+        return false;
+    }
+    if (!state.links.compact()) {
+        std::cerr << "Error: Failed to spill the links to " << tmp_directory << std::endl;
+        return false;
+    }
+
+    // Verify that a segment line existed for every segment name given in link lines.
+    for (std::size_t idx = 0; idx < state.segments.size(); ++idx) {
+        if (!state.segments.has_sequence(idx)) {
+            std::cerr << "Error: Segment line missing for segment with name " << state.segments.idx_to_gfa1_name(idx) << std::endl;
+            return false;
+        }
+    }
+
+    if (!out_stem.empty()) {
+        if (!state.links.write_out(out_stem + ".edges")) {
+            std::cerr << "Error: Failed to write " << out_stem << ".edges" << std::endl;
+            return false;
+        }
+        if (!state.segments.write_out()) {
+            std::cerr << "Error: Failed to write " << out_stem << ".unitigs" << std::endl;
+            return false;
+        }
+        if (!state.segments.write_lengths(out_stem + ".lengths")) {
+            std::cerr << "Error: Failed to write " << out_stem << ".lengths" << std::endl;
+            return false;
+        }
+        if (!state.parser->open_path_files(out_stem + ".fasta", out_stem + ".paths", path_directory)) {
+            std::cerr << "Error: Can't open " << out_stem << ".fasta or " << out_stem << ".paths" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+Graph Gfa1Graphs::build_cdbg(int_t kmer_length) {
+    State& state = *m_state;
+    Graph graph(false, true);
+    for (std::size_t idx = 0; idx < state.segments.size(); ++idx) {
+        real_t self_edge_weight = (real_t) state.segments.length(idx) - kmer_length;
+        if (self_edge_weight < 0.0) {
+            std::cerr << "self_edge_weight = " << self_edge_weight << " < 0.0 -- wrong k-mer length?" << std::endl;
+            return Graph();
+        }
+        graph.add_two_sided_node(self_edge_weight);
+    }
+    bool links_ok = state.links.for_each_link([&graph](uint64_t from_id, uint64_t to_id, uint64_t edge_type, uint64_t overlap) {
+        if (overlap == 0) return; // Non-overlapping edges ignored.
+        int_t v = 2 * from_id + !(edge_type & 2); // F* edge means link comes from v's right side.
+        int_t w = 2 * to_id + (edge_type & 1); // *R edge means link goes to w's right side.
+        graph.add_edge(v, w, 1.0); // Weight 1.0 by definition.
+    });
+    if (!links_ok) {
+        std::cerr << "Error: Failed to read back the spilled links from " << state.tmp_directory << std::endl;
+        return Graph();
+    }
+    if (!graph.finalize()) return Graph();
+    return graph;
+}
+
+std::size_t Gfa1Graphs::n_sggs() const { return m_state->path_data.n_paths(); }
+
+bool Gfa1Graphs::build_sggs(const Graph& cdbg, std::size_t i, std::vector<SingleGenomeGraph>& sg_graphs) {
+    State& state = *m_state;
+    state.cdbg = &cdbg;
+    state.sg_graphs = &sg_graphs;
+    state.batch_begin = i;
+    bool ok = state.parser->finish_paths(i, i + sg_graphs.size());
+    state.sg_graphs = nullptr;
+    state.n_finished_paths = i + sg_graphs.size();
+    if (!ok) state.errors.print_errors();
+    return ok;
+}
+
+bool Gfa1Graphs::finish() {
+    State& state = *m_state;
+    if (state.out_stem.empty()) return true;
+    const std::size_t batch_size = state.parser->batch_size();
+    for (std::size_t i = state.n_finished_paths; i < n_sggs(); i += batch_size) {
+        if (!state.parser->finish_paths(i, std::min(i + batch_size, n_sggs()))) {
+            state.errors.print_errors();
+            return false;
+        }
+    }
+    state.n_finished_paths = n_sggs();
+    if (!state.parser->close_path_files()) {
+        std::cerr << "Error: Failed to write " << state.out_stem << ".fasta or " << state.out_stem << ".paths" << std::endl;
+        return false;
+    }
+    state.paths.write_counts(state.out_stem + ".counts");
+    return true;
+}
@@ -5,13 +5,19 @@ int ProgramOptions::argc;
 char** ProgramOptions::argv;
 
 std::string ProgramOptions::unitigs_filename = "";
+std::string ProgramOptions::lengths_filename = "";
 std::string ProgramOptions::edges_filename = "";
+std::string ProgramOptions::gfa1_filename = "";
+std::string ProgramOptions::gfa1_out_stem = "";
 std::string ProgramOptions::queries_filename = "";
 std::string ProgramOptions::sggs_filename = "";
 std::string ProgramOptions::out_stem = "out";
+std::string ProgramOptions::ch_filename = "";
+std::string ProgramOptions::landmark_selection = "farthest";
 int_t ProgramOptions::k = 0; 
 int_t ProgramOptions::n_queries = INT_T_MAX;
 int_t ProgramOptions::queries_format = -1;
+int_t ProgramOptions::n_landmarks = 0;
 real_t ProgramOptions::max_distance = REAL_T_MAX;
 int_t ProgramOptions::n_threads = 1; 
 int_t ProgramOptions::sgg_count_threshold = 10;
@@ -26,6 +32,9 @@ bool ProgramOptions::output_one_based = false;
 bool ProgramOptions::run_sggs_only = false;
 bool ProgramOptions::output_outliers = false;
 bool ProgramOptions::verbose = false;
+bool ProgramOptions::binary_graph = false;
+bool ProgramOptions::gfa1_sggs = false;
+uint64_t ProgramOptions::gfa1_max_memory = 0;
 
 bool ProgramOptions::valid_state = true;
 
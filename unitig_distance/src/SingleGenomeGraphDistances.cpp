@@ -1,3 +1,5 @@
+#include <fstream>
+#include <functional>
 #include <iostream>
 #include <string>
 #include <thread>
@@ -5,8 +7,10 @@
 
 #include "DistanceVector.hpp"
 #include "Graph.hpp"
+#include "PackedSggs.hpp"
 #include "PrintUtils.hpp"
 #include "SearchJobs.hpp"
+#include "SearchWorkspace.hpp"
 #include "SingleGenomeGraph.hpp"
 #include "SingleGenomeGraphBuilder.hpp"
 #include "SingleGenomeGraphDistances.hpp"
@@ -14,21 +18,68 @@
 #include "types.hpp"
 
 DistanceVector calculate_sgg_distances(const Graph& graph, const SearchJobs& search_jobs, Timer& timer) {
+    // Read single genome graph edge files, or the index of a packed single genome graphs file.
+    std::vector<std::string> path_edge_files;
+    PackedSggs packed_sggs;
+    bool packed = PackedSggs::is_packed(ProgramOptions::sggs_filename);
+    if (packed) {
+        if (!packed_sggs.open(ProgramOptions::sggs_filename)) {
+            std::cerr << "Error: Couldn't read packed single genome graphs file." << std::endl;
+            return DistanceVector();
+        }
+    } else {
+        std::ifstream ifs(ProgramOptions::sggs_filename);
+        for (std::string path_edges; std::getline(ifs, path_edges); ) path_edge_files.emplace_back(path_edges);
+    }
+    std::size_t n_sggs = packed ? packed_sggs.size() : path_edge_files.size();
+
+    if (n_sggs == 0) {
+        std::cerr << "Error: Couldn't read single genome graph files." << std::endl;
+        return DistanceVector();
+    }
+
+    // Construct a batch of single genome graphs. Packed edge blocks are read here sequentially from the single open file.
+    auto build_batch = [&graph, &packed_sggs, &path_edge_files, packed](std::size_t i, std::vector<SingleGenomeGraph>& sg_graphs) {
+        std::size_t batch = sg_graphs.size();
+        std::vector<std::string> edge_blocks(packed ? batch : 0);
+        for (std::size_t thr = 0; thr < edge_blocks.size(); ++thr) {
+            if (!packed_sggs.read(i + thr, edge_blocks[thr])) {
+                std::cerr << "Error: Couldn't read " << packed_sggs.name(i + thr) << " from packed single genome graphs file." << std::endl;
+                return false;
+            }
+        }
+        auto construct_sgg = [&graph, &sg_graphs, &edge_blocks, &packed_sggs, &path_edge_files, packed, i](int_t thr) {
+            if (packed) {
+                sg_graphs[thr] = SingleGenomeGraphBuilder::build_sgg_from_block(graph, edge_blocks[thr], packed_sggs.name(i + thr));
+            } else {
+                sg_graphs[thr] = SingleGenomeGraphBuilder::build_sgg(graph, path_edge_files[i + thr]);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (std::size_t thr = 0; thr < batch; ++thr) threads.emplace_back(construct_sgg, thr);
+        for (auto& thr : threads) thr.join();
+        return true;
+    };
+
+    return calculate_sgg_distances(search_jobs, timer, n_sggs, build_batch);
+}
+
+DistanceVector calculate_sgg_distances(const SearchJobs& search_jobs, Timer& timer, std::size_t n_sggs, const sgg_batch_builder_t& build_batch) {
     DistanceVector sgg_distances(search_jobs.n_queries(), 0.0, 0);
 
     sgg_distances.set_mean_distances();
 
-    // Read single genome graph edge files.
-    std::vector<std::string> path_edge_files;
-    std::ifstream ifs(ProgramOptions::sggs_filename);
-    for (std::string path_edges; std::getline(ifs, path_edges); ) path_edge_files.emplace_back(path_edges);
-    std::size_t n_sggs = path_edge_files.size(), batch_size = ProgramOptions::n_threads;
+    std::size_t batch_size = ProgramOptions::n_threads;
 
     if (n_sggs == 0) {
-        std::cerr << "Error: Couldn't read single genome graph files." << std::endl;
+        std::cerr << "Error: No single genome graphs to construct." << std::endl;
         return DistanceVector();
     }
 
+    // Search memory of each thread, reused across the single genome graphs.
+    std::vector<SearchWorkspace> workspaces(ProgramOptions::n_threads);
+
     // Printing variables for verbose mode.
     Timer t_sgg, t_sgg_distances, t_deconstruct;
     int_t print_interval = (n_sggs + 4) / 5, print_i = 1, n_nodes = 0, n_edges = 0;
@@ -54,13 +105,7 @@ DistanceVector calculate_sgg_distances(const Graph& graph, const SearchJobs& sea
 
         // Construct a batch of single genome graphs.
         std::vector<SingleGenomeGraph> sg_graphs(batch);
-        auto construct_sgg = [&graph, &sg_graphs](int_t thr, const std::string& path_edges) {
-            sg_graphs[thr] = SingleGenomeGraphBuilder::build_sgg(graph, path_edges);
-        };
-
-        std::vector<std::thread> threads;
-        for (std::size_t thr = 0; thr < batch; ++thr) threads.emplace_back(construct_sgg, thr, path_edge_files[i + thr]);
-        for (auto& thr : threads) thr.join();
+        if (!build_batch(i, sg_graphs)) return DistanceVector();
 
         for (const auto& sg_graph : sg_graphs) {
             if (sg_graph.size() == 0) {
@@ -78,14 +123,14 @@ DistanceVector calculate_sgg_distances(const Graph& graph, const SearchJobs& sea
             // Update n_nodes and n_edges.
             for (const auto& sg_graph : sg_graphs) {
                 n_nodes += sg_graph.size();
-                for (const auto& adj : sg_graph) n_edges += adj.size();
+                n_edges += sg_graph.n_edges();
             }
             t_sgg_distances.set_mark();
         }
 
         // Calculate distances in the single genome graphs.
         for (const auto& sg_graph : sg_graphs) {
-            auto sgg_batch_distances = SingleGenomeGraphDistances(sg_graph).solve(search_jobs);
+            auto sgg_batch_distances = SingleGenomeGraphDistances(sg_graph, workspaces).solve(search_jobs);
             // Combine results across threads.
             for (const auto& distances : sgg_batch_distances) {
                 for (const auto& result : distances) {
@@ -118,7 +163,7 @@ DistanceVector calculate_sgg_distances(const Graph& graph, const SearchJobs& sea
 
     if (ProgramOptions::verbose) {
         n_nodes /= n_sggs;
-        n_edges /= 2 * n_sggs;
+        n_edges /= n_sggs;
         PrintUtils::print_tbss(timer, "Constructing", n_sggs, "single genome graphs took", t_sgg.get_stopwatch_time());
         PrintUtils::print_tbss(timer, "The compressed single genome graphs have on average", Utils::neat_number_str(n_nodes), "connected nodes and", 
                                Utils::neat_number_str(n_edges), "edges");
@@ -1,9 +1,13 @@
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include "QueriesReader.hpp"
+#include "ContractionHierarchy.hpp"
+#include "Gfa1Graphs.hpp"
 #include "GraphBuilder.hpp"
 #include "GraphDistances.hpp"
+#include "Landmarks.hpp"
 #include "OperatingMode.hpp"
 #include "OutlierTools.hpp"
 #include "PrintUtils.hpp"
@@ -45,8 +49,15 @@ int main(int argc, char** argv) {
     const SearchJobs search_jobs(queries);
     if (ProgramOptions::verbose) PrintUtils::print_tbss_tsmasm(timer, "Prepared", Utils::neat_number_str(search_jobs.size()), "search jobs");
 
-    // Construct the graph according to operating mode.
-    const auto graph = GraphBuilder::build_correct_graph();
+    // Construct the graph according to operating mode, or from the GFA1 file in-process.
+    Gfa1Graphs gfa1_graphs;
+    bool from_gfa1 = !ProgramOptions::gfa1_filename.empty();
+    if (from_gfa1) {
+        if (!gfa1_graphs.read(ProgramOptions::gfa1_filename, ProgramOptions::gfa1_out_stem, ProgramOptions::n_threads,
+                              ProgramOptions::gfa1_max_memory, ProgramOptions::gfa1_tmp_directory())) return fail_with_error("Error: Failed to read GFA1 file.");
+        if (ProgramOptions::verbose) PrintUtils::print_tbss_tsmasm(timer, "Read GFA1 file", ProgramOptions::gfa1_filename);
+    }
+    const auto graph = from_gfa1 ? gfa1_graphs.build_cdbg(ProgramOptions::k) : GraphBuilder::build_correct_graph();
     if (graph.size() == 0) return fail_with_error("Error: Failed to construct main graph.");
     if (ProgramOptions::verbose) {
         PrintUtils::print_tbss_tsmasm_noendl(timer, "Constructed main graph");
@@ -55,7 +66,10 @@ int main(int argc, char** argv) {
 
     // Calculate distances in the single genome graphs if the single genome graph files were provided.
     if (ProgramOptions::has_operating_mode(OperatingMode::SGGS)) {
-        const auto sgg_distances = calculate_sgg_distances(graph, search_jobs, timer);
+        const auto sgg_distances = !from_gfa1 ? calculate_sgg_distances(graph, search_jobs, timer)
+            : calculate_sgg_distances(search_jobs, timer, gfa1_graphs.n_sggs(), [&graph, &gfa1_graphs](std::size_t i, std::vector<SingleGenomeGraph>& sg_graphs) {
+                return gfa1_graphs.build_sggs(graph, i, sg_graphs);
+            });
 
         if (sgg_distances.size() == 0) return 1;
 
@@ -70,12 +84,42 @@ int main(int argc, char** argv) {
 
     }
 
+    // Write the rest of gfa1_parser's output files if asked for.
+    if (from_gfa1 && !gfa1_graphs.finish()) return fail_with_error("Error: Failed to write GFA1 output files.");
+
     // Run normal graph
     if (!ProgramOptions::run_sggs_only) {
+        // Load the contraction hierarchy of the graph, or build and save it if the file doesn't exist. An existing file that can't be used
+        // is never overwritten.
+        ContractionHierarchy ch;
+        if (!ProgramOptions::ch_filename.empty()) {
+            if (Utils::file_exists(ProgramOptions::ch_filename)) {
+                std::string error;
+                if (!ch.load(ProgramOptions::ch_filename, graph, error)) {
+                    return fail_with_error("Error: Can't use contraction hierarchy file " + ProgramOptions::ch_filename + ": " + error
+                                           + ". Remove it to build a new one.");
+                }
+                if (ProgramOptions::verbose) PrintUtils::print_tbss_tsmasm(timer, "Loaded contraction hierarchy from file", ProgramOptions::ch_filename);
+            } else {
+                if (!ch.build(graph, timer, ProgramOptions::n_threads)) return fail_with_error("Error: Failed to build contraction hierarchy.");
+                if (ProgramOptions::verbose) PrintUtils::print_tbss_tsmasm(timer, "Built contraction hierarchy with", Utils::neat_number_str(ch.n_edges()), "upward edges");
+                if (!ch.save(ProgramOptions::ch_filename, graph)) return fail_with_error("Error: Failed to write contraction hierarchy file.");
+                if (ProgramOptions::verbose) PrintUtils::print_tbss_tsmasm(timer, "Saved contraction hierarchy to file", ProgramOptions::ch_filename);
+            }
+        }
+
+        // Select landmarks and compute their distance tables.
+        Landmarks landmarks;
+        if (ProgramOptions::n_landmarks > 0) {
+            bool farthest = ProgramOptions::landmark_selection == "farthest";
+            if (!landmarks.select(graph, ProgramOptions::n_landmarks, farthest, ProgramOptions::n_threads)) return fail_with_error("Error: Failed to select landmarks.");
+            if (ProgramOptions::verbose) PrintUtils::print_tbss_tsmasm(timer, "Selected", landmarks.size(), "landmarks and computed their distance tables");
+        }
+
         if (ProgramOptions::verbose) PrintUtils::print_tbssasm(timer, "Calculating distances in the main graph");
 
         // Calculate distances.
-        const auto graph_distances = GraphDistances(graph, timer).solve(search_jobs);
+        const auto graph_distances = GraphDistances(graph, timer, ch.size() > 0 ? &ch : nullptr, landmarks.size() > 0 ? &landmarks : nullptr).solve(search_jobs);
         timer.set_mark();
 
         ResultsWriter::output_results(ProgramOptions::out_filename(), queries, graph_distances);